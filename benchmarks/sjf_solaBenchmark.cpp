@@ -0,0 +1,77 @@
+//
+//  sjf_solaBenchmark.cpp
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Times sjf_sola::stretch on a 5 minute stereo sample at stretch factors from 0.5 to 4,
+//  with one thread and with one thread per hardware thread, and checks that both give the same output
+//
+//  Needs a JuceHeader.h ( juce_core and juce_audio_basics ) on the include path, e.g.
+//      g++ -std=c++17 -O2 -I<path to JuceLibraryCode> -I.. sjf_solaBenchmark.cpp -o solaBenchmark -lpthread
+//      ./solaBenchmark [ seconds ( default 300 ) ]
+//
+
+#include <JuceHeader.h>
+#include "../sjf_sola.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <cmath>
+
+namespace
+{
+    using clock = std::chrono::steady_clock;
+
+    double secondsSince( clock::time_point start )
+    {
+        return std::chrono::duration< double >( clock::now() - start ).count();
+    }
+
+    /** two detuned sweeping sines plus noise, so the cross correlation has something to line up */
+    void fillTestSignal( juce::AudioBuffer< float >& buffer )
+    {
+        std::mt19937 rng( 1 );
+        std::normal_distribution< float > noise( 0.0f, 0.1f );
+        const auto nSamps = buffer.getNumSamples();
+        for ( auto c = 0; c < buffer.getNumChannels(); c++ )
+        {
+            auto* data = buffer.getWritePointer( c );
+            for ( auto i = 0; i < nSamps; i++ )
+            {
+                const auto t = static_cast< float >( i );
+                data[ i ] = 0.3f * std::sin( t * 0.0123f * ( 1 + c ) + 0.00001f * t * t / nSamps ) + 0.2f * std::sin( t * 0.071f ) + noise( rng );
+            }
+        }
+    }
+}
+
+int main( int argc, char** argv )
+{
+    constexpr auto sampleRate = 44100;
+    const auto seconds = argc > 1 ? std::atoi( argv[ 1 ] ) : 300;
+    juce::AudioBuffer< float > original( 2, sampleRate * seconds );
+    fillTestSignal( original );
+    std::printf( "%d seconds of stereo audio at %d Hz\n", seconds, sampleRate );
+
+    for ( auto factor : { 0.5f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f } )
+    {
+        juce::AudioBuffer< float > singleThread, allThreads;
+        auto start = clock::now();
+        sjf_sola< float >::stretch( original, singleThread, factor, 2048, 256, 0, 1 );
+        const auto singleTime = secondsSince( start );
+        start = clock::now();
+        sjf_sola< float >::stretch( original, allThreads, factor );
+        const auto allTime = secondsSince( start );
+
+        auto maxDiff = 0.0;
+        for ( auto c = 0; c < 2; c++ )
+            for ( auto i = 0; i < singleThread.getNumSamples(); i++ )
+                maxDiff = std::max( maxDiff, static_cast< double >( std::abs( singleThread.getSample( c, i ) - allThreads.getSample( c, i ) ) ) );
+
+        std::printf( "factor %.1f: 1 thread %6.2fs ( %5.0fx realtime )  all threads %6.2fs ( %5.0fx realtime )  output %d samples, max difference %.3g\n",
+                    factor, singleTime, seconds / singleTime, allTime, seconds / allTime, allThreads.getNumSamples(), maxDiff );
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+//
+//  sjf_waveguideBenchmark.cpp
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Pitch accuracy and speed of sjf_waveguide< float > and sjf_waveguide< double > for every midi note from 21 to 108
+//  The pitch of each note is found from the peak of a windowed fourier transform of the middle of the first half second
+//  Returns 1 if
+//      --> float and double are more than 0.1 cents apart
+//      --> either has moved more than 0.5 cents from the pitch the double only waveguide produced before it was templated
+//  With the default parameters the waveguide is flat of the midi pitch, by 13 cents at the bottom rising to over 300 cents at the top,
+//  the double only version was just as flat so the reference table holds those offsets rather than 0
+//
+//  Needs a JuceHeader.h on the include path and sjf_delayLine.h from ARCHIVED, e.g.
+//      g++ -std=c++17 -O2 -I<path to JuceLibraryCode> -I.. -I../ARCHIVED sjf_waveguideBenchmark.cpp -o waveguideBenchmark
+//      ./waveguideBenchmark
+//
+
+#include <JuceHeader.h>
+#include "../sjf_waveguide.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr auto LOWEST_NOTE = 21, HIGHEST_NOTE = 108, NNOTES = HIGHEST_NOTE - LOWEST_NOTE + 1;
+    constexpr auto SAMPLE_RATE = 48000.0;
+    constexpr auto FLOAT_TOLERANCE_CENTS = 0.1, REFERENCE_TOLERANCE_CENTS = 0.5;
+
+    /** cents away from the midi pitch measured from the double only sjf_waveguide ( before sjf_waveguide< T > ), default parameters, decay of 4 seconds, velocity 100 */
+    constexpr std::array< double, NNOTES > REFERENCE_CENTS
+    {
+        -12.93, -13.00, -13.05, -12.82, -13.07, -13.34, -13.34, -13.44, -13.61, -13.69, -13.79, -14.00, -14.13,
+        -14.30, -14.49, -14.67, -14.91, -15.12, -15.38, -15.65, -15.94, -16.26, -16.60, -16.97, -17.38, -17.81,
+        -18.28, -18.80, -19.36, -19.96, -20.62, -21.33, -22.10, -22.94, -23.85, -24.84, -26.10, -27.64, -29.27,
+        -31.00, -32.83, -34.76, -36.80, -38.97, -41.26, -43.68, -46.24, -48.95, -51.82, -54.85, -58.06, -61.45,
+        -65.04, -68.83, -72.84, -77.07, -81.55, -86.28, -91.28, -96.54, -102.13, -108.01, -114.23, -120.76, -127.72,
+        -135.02, -142.72, -150.84, -159.40, -168.43, -177.96, -188.00, -198.54, -209.54, -221.28, -166.20, -175.65,
+        -185.57, -195.96, -206.87, -218.37, -230.49, -243.26, -256.66, -270.59, -284.87, -300.73, -317.16
+    };
+
+    /** render half a second of a note, adding the time spent in processSample to seconds */
+    template < class T >
+    std::vector< double > renderNote( int midiNote, double& seconds )
+    {
+        sjf_waveguide< T > wg;
+        wg.prepare( SAMPLE_RATE );
+        wg.setDecay( 4 );
+        wg.triggerNewNote( midiNote, 100 );
+        std::vector< double > output( static_cast< size_t >( SAMPLE_RATE * 0.5 ) );
+        auto start = std::chrono::steady_clock::now();
+        for ( size_t i = 0; i < output.size(); i++ )
+            output[ i ] = wg.processSample( static_cast< int >( i ) );
+        seconds += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+        return output;
+    }
+
+    /** frequency of the biggest peak between 0.8 and 1.05 times the expected frequency, refined by halving the search step */
+    double measurePitch( const std::vector< double >& y, double expectedFrequency )
+    {
+        const auto start = y.size() / 4, len = y.size() / 2;
+        auto magnitude = [ & ]( double f )
+        {
+            auto re = 0.0, im = 0.0;
+            for ( size_t i = 0; i < len; i++ )
+            {
+                auto w = 0.5 - 0.5 * std::cos( 2.0 * M_PI * i / len );
+                auto phase = 2.0 * M_PI * f * i / SAMPLE_RATE;
+                re += y[ start + i ] * w * std::cos( phase );
+                im -= y[ start + i ] * w * std::sin( phase );
+            }
+            return re * re + im * im;
+        };
+        auto step = expectedFrequency * 0.0005;
+        auto bestF = expectedFrequency, best = -1.0;
+        for ( auto f = expectedFrequency * 0.8; f <= expectedFrequency * 1.05; f += step )
+        {
+            auto m = magnitude( f );
+            if ( m > best ) { best = m; bestF = f; }
+        }
+        for ( auto k = 0; k < 30; k++ )
+        {
+            step *= 0.5;
+            auto lower = magnitude( bestF - step ), upper = magnitude( bestF + step );
+            if ( lower > best ) { best = lower; bestF -= step; }
+            else if ( upper > best ) { best = upper; bestF += step; }
+        }
+        return bestF;
+    }
+
+    double cents( double f, double reference ) { return 1200.0 * std::log2( f / reference ); }
+}
+
+int main()
+{
+    auto doubleSeconds = 0.0, floatSeconds = 0.0, maxFloatCents = 0.0, maxReferenceCents = 0.0;
+    auto failures = 0;
+    std::printf( "note   target Hz   double Hz    float Hz   double cents   float vs double cents\n" );
+    for ( auto note = LOWEST_NOTE; note <= HIGHEST_NOTE; note++ )
+    {
+        const auto target = midiToFrequency< double >( note );
+        const auto fDouble = measurePitch( renderNote< double >( note, doubleSeconds ), target );
+        const auto fFloat = measurePitch( renderNote< float >( note, floatSeconds ), target );
+        const auto doubleCents = cents( fDouble, target ), floatCents = cents( fFloat, fDouble );
+        const auto referenceCents = std::max( std::abs( doubleCents - REFERENCE_CENTS[ note - LOWEST_NOTE ] ), std::abs( cents( fFloat, target ) - REFERENCE_CENTS[ note - LOWEST_NOTE ] ) );
+        maxFloatCents = std::max( maxFloatCents, std::abs( floatCents ) );
+        maxReferenceCents = std::max( maxReferenceCents, referenceCents );
+        const auto failed = std::abs( floatCents ) > FLOAT_TOLERANCE_CENTS || referenceCents > REFERENCE_TOLERANCE_CENTS;
+        failures += failed;
+        std::printf( "%4d %11.3f %11.3f %11.3f %14.2f %23.4f%s\n", note, target, fDouble, fFloat, doubleCents, floatCents, failed ? "  FAIL" : "" );
+    }
+    const auto nSamples = NNOTES * SAMPLE_RATE * 0.5;
+    std::printf( "max float vs double %.4f cents, max change from reference %.3f cents\n", maxFloatCents, maxReferenceCents );
+    std::printf( "double %.1f ns per sample, float %.1f ns per sample\n", doubleSeconds / nSamples * 1e9, floatSeconds / nSamples * 1e9 );
+    std::printf( "%s\n", failures == 0 ? "PASSED" : "FAILED" );
+    return failures == 0 ? 0 : 1;
+}
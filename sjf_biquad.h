@@ -6,6 +6,7 @@
 
 #ifndef sjf_biquad_h
 #define sjf_biquad_h
+#include <array>
 
 // implementation of biquad filter
 //
@@ -23,20 +24,50 @@ public:
         return output;
     }
     
-    void setCoefficients( const std::vector< T > &coefficients )
+    // { b0, b1, b2, a1, a2 } as output by sjf_biquadCalculator
+    void setCoefficients( const std::array< T, 5 > &coefficients )
     {
-        if ( coefficients.size() != 5 )
-        {
-            return;
-        }
         m_b0 = coefficients[ 0 ];
         m_b1 = coefficients[ 1 ];
         m_b2 = coefficients[ 2 ];
         m_a1 = -1 * coefficients[ 3 ];
         m_a2 = -1 * coefficients[ 4 ];
+        m_rampCount = 0;
 //        DBG("m_b0 " << m_b0 << " m_b1 " << m_b1 << " m_b2 " << m_b2 << " m_a1 " << m_a1 << " m_a2" << m_a2 );
     }
     
+    // moves linearly from the current coefficients to the new ones over the next nSamples calls to filterInputRamped()
+    // the stable region of a1/a2 is a triangle, so every step between two stable filters is also stable
+    void setCoefficientsRamped( const std::array< T, 5 > &coefficients, int nSamples )
+    {
+        if ( nSamples < 2 )
+        {
+            setCoefficients( coefficients );
+            return;
+        }
+        T scale = 1.0 / nSamples;
+        m_b0Inc = ( coefficients[ 0 ] - m_b0 ) * scale;
+        m_b1Inc = ( coefficients[ 1 ] - m_b1 ) * scale;
+        m_b2Inc = ( coefficients[ 2 ] - m_b2 ) * scale;
+        m_a1Inc = ( -coefficients[ 3 ] - m_a1 ) * scale;
+        m_a2Inc = ( -coefficients[ 4 ] - m_a2 ) * scale;
+        m_rampCount = nSamples;
+    }
+    
+    T filterInputRamped( T input )
+    {
+        if ( m_rampCount > 0 )
+        {
+            m_b0 += m_b0Inc;
+            m_b1 += m_b1Inc;
+            m_b2 += m_b2Inc;
+            m_a1 += m_a1Inc;
+            m_a2 += m_a2Inc;
+            --m_rampCount;
+        }
+        return filterInput( input );
+    }
+    
     T getD1() { return m_d1; }
     
     T getD2() { return m_d2; }
@@ -46,6 +77,8 @@ private:
     
     T m_d1 = 0, m_d2 = 0;
     T m_a1, m_a2, m_b0, m_b1, m_b2;
+    T m_a1Inc = 0, m_a2Inc = 0, m_b0Inc = 0, m_b1Inc = 0, m_b2Inc = 0;
+    int m_rampCount = 0;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_biquad )
 };
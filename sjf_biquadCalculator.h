@@ -7,6 +7,9 @@
 #ifndef sjf_biquadCalculator_h
 #define sjf_biquadCalculator_h
 
+#include <array>
+#include <cmath>
+#include "sjf_mathsApproximations.h"
 
 
 // coefficientCalculator For biquad filter
@@ -21,9 +24,11 @@
 template <class T>
 class sjf_biquadCalculator {
 public:
+    // { b0, b1, b2, a1, a2 }
+    using coefficients = std::array< T, 5 >;
+    
     sjf_biquadCalculator()
     {
-        m_coeffs.resize( 5 );
         initialise ( 44100 );
     };
     ~sjf_biquadCalculator(){ };
@@ -34,6 +39,7 @@ public:
         m_angFreqFactor = m_pi / m_SR;
         m_K = tan( m_f0 * m_angFreqFactor );
         m_V0 = pow(10, (m_dBGain/20) );
+        m_rootV0 = sqrt( m_V0 );
     }
     
     void setFrequency( T fr )
@@ -43,6 +49,14 @@ public:
 //        calculateIntermediateValues();
     }
     
+    // same as setFrequency but with a pade approximation of tan ( relative error < 4e-9 up to 0.45 * sampleRate )
+    // cheap enough to be used every sample for modulated filters
+    void setFrequencyApprox( T fr )
+    {
+        m_f0 = fr;
+        m_K = sjf::maths::tanApprox( m_f0 * m_angFreqFactor );
+    }
+    
     T getFrequency()
     {
         return m_f0;
@@ -52,6 +66,7 @@ public:
     void setQFactor( T Q )
     {
         m_Q = Q;
+        m_invQ = 1.0 / m_Q;
 //        calculateIntermediateValues();
     }
     
@@ -64,10 +79,12 @@ public:
     {
         m_dBGain = gain;
         m_V0 = pow(10, (m_dBGain/20) );
+        m_rootV0 = sqrt( m_V0 );
 //        calculateIntermediateValues();
     }
     
-    std::vector< T > getCoefficients()
+    // only the frequency dependent terms are calculated here, anything that depends on Q or gain alone is cached when they are set
+    const coefficients& getCoefficients()
     {
         switch (m_type)
         {
@@ -231,8 +248,8 @@ private:
         else
         {
             T K2 = m_K * m_K;
-            T root2 = 1/m_Q; // square root of 2 is replaced by Q --> 1/0.7071 == sqrt(2)
-            T rootV0 = sqrt( m_V0 );
+            T root2 = m_invQ; // square root of 2 is replaced by Q --> 1/0.7071 == sqrt(2)
+            T rootV0 = m_rootV0;
             T root2K = root2 * m_K;
             T root2rootV0K = root2K * rootV0;
             T V0K2 = m_V0 * K2;
@@ -282,8 +299,8 @@ private:
         else
         {
             T K2 = m_K * m_K;
-            T root2 = 1/m_Q; // square root of 2 is replaced by Q --> 1/0.7071 == sqrt(2)
-            T rootV0 = sqrt( m_V0 );
+            T root2 = m_invQ; // square root of 2 is replaced by Q --> 1/0.7071 == sqrt(2)
+            T rootV0 = m_rootV0;
             T root2K = root2 * m_K;
             T root2rootV0K = root2K * rootV0;
             T V0K2 = m_V0 * K2;
@@ -367,9 +384,10 @@ private:
     
     T m_f0 = 1000, m_Q = 1, m_SR = 44100, m_dBGain = 0; // user variables
     T m_angFreqFactor = m_pi / m_SR, m_K = tan( m_f0 * m_angFreqFactor ), m_V0 = pow(10, (m_dBGain/20) );// other calculation Variables
+    T m_invQ = 1.0 / m_Q, m_rootV0 = sqrt( m_V0 );
     bool m_isFirstOrder = false;
     int m_type = 1;
-    std::vector < T > m_coeffs;
+    coefficients m_coeffs{ 1, 0, 0, 0, 0 };
     
     
 
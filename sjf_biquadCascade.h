@@ -8,11 +8,162 @@
 #define sjf_biquadCascade_h
 
 #include "sjf_biquadWrapper.h"
+#include "gcem/include/gcem.hpp"
+#include <array>
+#include <cmath>
 
 // implementation of biquadCascade
-// maximum of 5 stages ==> 10th order
-#define MAX_NUM_STAGES 5
+// maximum of 8 stages ==> 16th order
+#define MAX_NUM_STAGES 8
 #define MAX_ORDER MAX_NUM_STAGES*2
+
+namespace sjf::filters::cascadeDesign
+{
+    /**
+     The stages of a lowpass prototype for a particular design and order
+        fsf --> the frequency of each stage relative to the -3dB cutoff of the whole cascade ( highpass stages use the reciprocal )
+        q   --> the Q factor of each stage
+        gain --> passband gain applied to the lowpass/highpass numerator of the first stage ( only used by even order chebyshev )
+     Second order stages are ordered from lowest to highest Q, if the order is odd the last stage is first order
+     Unused stages are set to a harmless second order stage so a whole array can be calculated in one pass
+     */
+    struct stages
+    {
+        std::array< double, MAX_NUM_STAGES > fsf{}, q{};
+        double gain = 1;
+        int nStages = 0;
+        bool firstOrderLast = false;
+    };
+
+    constexpr stages emptyDesign( int order )
+    {
+        stages d;
+        for ( auto s = 0; s < MAX_NUM_STAGES; s++ )
+        {
+            d.fsf[ s ] = 1;
+            d.q[ s ] = M_SQRT1_2;
+        }
+        d.nStages = ( order + 1 ) / 2;
+        d.firstOrderLast = order % 2 != 0;
+        return d;
+    }
+
+    // poles are evenly spaced around the unit circle, the angle of each pair from the real axis sets its Q
+    constexpr stages butterworth( int order )
+    {
+        auto d = emptyDesign( order );
+        for ( auto k = 0; k < order / 2; k++ )
+            d.q[ k ] = 1.0 / ( 2.0 * gcem::cos( M_PI * ( 2 * k + 1 + order % 2 ) / ( 2.0 * order ) ) );
+        return d;
+    }
+
+    // type 1 chebyshev with the given passband ripple, the passband peaks at 0dB and the cascade is 3dB down at the cutoff
+    // each stage has unity gain at DC, which is the top of the ripple for odd orders but the bottom of it for even orders,
+    // so even orders are scaled down by the ripple
+    constexpr stages chebyshev( int order, double rippleDB )
+    {
+        auto d = emptyDesign( order );
+        const auto invEps = 1.0 / gcem::sqrt( gcem::pow( 10.0, rippleDB / 10.0 ) - 1.0 );
+        const auto mu = gcem::asinh( invEps ) / order;
+        const auto f3dB = gcem::cosh( gcem::acosh( invEps ) / order );
+        const auto nPairs = order / 2;
+        for ( auto k = 0; k < nPairs; k++ )
+        {
+            const auto theta = M_PI * ( 2 * ( nPairs - 1 - k ) + 1 ) / ( 2.0 * order );
+            const auto re = gcem::sinh( mu ) * gcem::sin( theta );
+            const auto im = gcem::cosh( mu ) * gcem::cos( theta );
+            const auto w0 = gcem::sqrt( re * re + im * im );
+            d.fsf[ k ] = w0 / f3dB;
+            d.q[ k ] = w0 / ( 2.0 * re );
+        }
+        if ( d.firstOrderLast )
+            d.fsf[ d.nStages - 1 ] = gcem::sinh( mu ) / f3dB;
+        else
+            d.gain = 1.0 / gcem::sqrt( 1.0 + 1.0 / ( invEps * invEps ) );
+        return d;
+    }
+
+    // two butterworth filters of half the order in series ( 6dB down at the cutoff, lowpass + highpass sum flat )
+    // the two first order stages of an odd half order combine into one stage with a Q of 0.5
+    // only even orders exist, odd orders are rounded up
+    constexpr stages linkwitzRiley( int order )
+    {
+        const auto halfOrder = ( order + 1 ) / 2;
+        const auto half = butterworth( halfOrder );
+        auto d = emptyDesign( halfOrder * 2 );
+        for ( auto k = 0; k < halfOrder / 2; k++ )
+        {
+            d.q[ 2 * k ] = half.q[ k ];
+            d.q[ 2 * k + 1 ] = half.q[ k ];
+        }
+        if ( half.firstOrderLast )
+            d.q[ d.nStages - 1 ] = 0.5;
+        return d;
+    }
+
+    // bessel poles have no closed form so these are tabulated for every order up to MAX_ORDER
+    // normalised so the cascade is 3dB down at the cutoff, the first order stage of odd orders is last
+    // [ stage ] [ order ]
+    static constexpr int BESSEL_MAX_ORDER = MAX_ORDER;
+    static constexpr double besselQCoefficients[ MAX_NUM_STAGES ][ BESSEL_MAX_ORDER ] =
+    {
+        { 1, 0.5774, 0.6910, 0.5219, 0.5635, 0.5103, 0.5324, 0.5060, 0.5197, 0.5039, 0.5133, 0.5028, 0.5096, 0.5020, 0.5072, 0.5016 }, // stage 1
+        { 1, 1, 1, 0.8055, 0.9165, 0.6112, 0.6608, 0.5596, 0.5894, 0.5376, 0.5578, 0.5259, 0.5406, 0.5190, 0.5302, 0.5146 }, // stage 2
+        { 1, 1, 1, 1, 1, 1.0233, 1.1263, 0.7109, 0.7606, 0.6205, 0.6521, 0.5794, 0.6018, 0.5567, 0.5736, 0.5427 }, // stage 3
+        { 1, 1, 1, 1, 1, 1, 1, 1.2257, 1.3219, 0.8098, 0.8583, 0.6840, 0.7159, 0.6248, 0.6480, 0.5911 }, // stage 4
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.4153, 1.5061, 0.9059, 0.9529, 0.7476, 0.7792, 0.6714 }, // stage 5
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.5947, 1.6811, 0.9990, 1.0444, 0.8104 }, // stage 6
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.7655, 1.8482, 1.0891 }, // stage 7
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.9293 } // stage 8
+    };
+
+    static constexpr double besselFSFCoefficients[ MAX_NUM_STAGES ][ BESSEL_MAX_ORDER ] =
+    {
+        { 1, 1.2720, 1.4476, 1.4302, 1.5563, 1.6039, 1.7164, 1.7785, 1.8784, 1.9427, 2.0328, 2.0961, 2.1786, 2.2401, 2.3165, 2.3758 }, // stage 1
+        { 1, 1, 1.3227, 1.6034, 1.7554, 1.6892, 1.8224, 1.8321, 1.9479, 1.9806, 2.0831, 2.1247, 2.2172, 2.2627, 2.3474, 2.3943 }, // stage 2
+        { 1, 1, 1, 1, 1.5023, 1.9047, 2.0495, 1.9532, 2.0804, 2.0622, 2.1745, 2.1850, 2.2857, 2.3096, 2.4014, 2.4323 }, // stage 3
+        { 1, 1, 1, 1, 1, 1, 1.6844, 2.1887, 2.3223, 2.2038, 2.3233, 2.2843, 2.3917, 2.3850, 2.4826, 2.4923 }, // stage 4
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1.8566, 2.4506, 2.5740, 2.4391, 2.5515, 2.4966, 2.5992, 2.5786 }, // stage 5
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2.0167, 2.6930, 2.8079, 2.6607, 2.7668, 2.6994 }, // stage 6
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2.1661, 2.9191, 3.0268, 2.8702 }, // stage 7
+        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2.3064, 3.1315 } // stage 8
+    };
+
+    constexpr stages bessel( int order )
+    {
+        auto d = emptyDesign( order );
+        for ( auto s = 0; s < d.nStages; s++ )
+        {
+            d.fsf[ s ] = besselFSFCoefficients[ s ][ order - 1 ];
+            d.q[ s ] = besselQCoefficients[ s ][ order - 1 ];
+        }
+        return d;
+    }
+
+    static constexpr double CHEBYSHEV_RIPPLE_DB = 1;
+
+    // one design for every order from 1 --> MAX_ORDER
+    template < typename Design >
+    constexpr std::array< stages, MAX_ORDER > makeTable( Design design )
+    {
+        std::array< stages, MAX_ORDER > table{};
+        for ( auto o = 1; o <= MAX_ORDER; o++ )
+            table[ o - 1 ] = design( o );
+        return table;
+    }
+
+    inline constexpr auto butterworthTable = makeTable( []( int order ){ return butterworth( order ); } );
+    inline constexpr auto besselTable = makeTable( []( int order ){ return bessel( order ); } );
+    inline constexpr auto chebyshevTable = makeTable( []( int order ){ return chebyshev( order, CHEBYSHEV_RIPPLE_DB ); } );
+    inline constexpr auto linkwitzRileyTable = makeTable( []( int order ){ return linkwitzRiley( order ); } );
+}
+
+//==============================================================================
+//==============================================================================
+//==============================================================================
+// stage frequencies and Qs come from the compile time designs above
+// lowpass and highpass coefficients for every stage are calculated together in one pass,
+// any other filter type set with setFilterType() is calculated stage by stage with sjf_biquadCalculator
 template <class T>
 class sjf_biquadCascade {
 public:
@@ -21,251 +172,224 @@ public:
         setNumOrders( 3 ); // start with a third order filter... just because...
     };
     ~sjf_biquadCascade() { };
-    
+
     void initialise( T sampleRate )
     {
-        for ( int i = 0; i < cascade.size(); i++ )
+        m_SR = sampleRate;
+        m_angFreqFactor = M_PI / m_SR;
+        m_calculator.initialise( sampleRate );
+        clear();
+        setFrequency( m_f0 );
+    }
+
+
+    T filterInput( T input )
+    {
+        for ( int i = 0; i < m_nStages; i++ )
         {
-            cascade[ i ].initialise( sampleRate );
+            input = m_stages[ i ].filterInput( input );
         }
+        return input;
     }
-    
-    
-    T filterInput( T input )
+
+    // for audio rate modulation of the cutoff
+    // exact coefficients for every stage are only calculated every m_modInterval samples ( see setModulationInterval() ) and ramped in between
+    T filterInput( T input, T f )
     {
+        if ( m_modCount == 0 )
+        {
+            m_modCount = m_modInterval;
+            if ( f != m_f0 )
+            {
+                m_f0 = f;
+                calculateCoefficients();
+                for ( int s = 0; s < m_nStages; s++ )
+                    m_stages[ s ].setCoefficientsRamped( m_coeffs[ s ], m_modInterval );
+            }
+        }
+        --m_modCount;
         for ( int i = 0; i < m_nStages; i++ )
         {
-            input = cascade[ i ].filterInput( input );
+            input = m_stages[ i ].filterInputRamped( input );
         }
         return input;
     }
-    
+
+    // number of samples between exact coefficient calculations when using filterInput( input, frequency )
+    void setModulationInterval( int nSamples )
+    {
+        m_modInterval = nSamples > 0 ? nSamples : 1;
+        m_modCount = 0;
+    }
+
     void setFilterDesign( const int design )
     {
         m_design = design;
-        setQFactors();
-        setFrequency( m_f0 );
+        updateDesign();
     }
-    
+
+    // 1 --> MAX_ORDER, linkwitzRiley rounds odd orders up
     void setNumOrders( int nOrders )
     {
 //        DBG(" NUM ORDERS " << nOrders);
         jassert( nOrders > 0 && nOrders <= MAX_ORDER );
         if ( m_nOrders != nOrders )
         {
-            for ( int i = 0; i < m_nStages; i ++ ) // set all stages but last of an odd number of orders to be second order... NOT WORKING
-            {
-                cascade[ i ].clear();
-            }
+            // stages that weren't in use may still hold old state and a stage may swap between first and second order
+            clear();
         }
         m_nOrders = nOrders;
-        m_nStages = ceil( m_nOrders * 0.5 ); // number of stages in us is equal to ceil(nOrders / 2)
+        updateDesign();
+    }
 
-        for ( int i = 0; i < m_nStages; i ++ ) // set all stages but last of an odd number of orders to be second order... NOT WORKING
-        {
-            if ( i == (m_nStages - 1) && m_nOrders %2 != 0 )
-            {
-                cascade[ i ].setOrder( true );
-            }
-            else
-            {
-                cascade[ i ].setOrder( false );
-            }
-        }
-        setQFactors();
-        setFrequency( m_f0 );
+    int getNumStages()
+    {
+        return m_nStages;
     }
-    
+
+    // calculates the coefficients for every stage in one pass
     void setFrequency( T f )
     {
         m_f0 = f;
-        switch ( m_design )
+        calculateCoefficients();
+        for ( int s = 0; s < m_nStages; s++ )
         {
-            case( butterworth ):
-                for ( int s = 0; s < m_nStages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setFrequency( m_f0 * butterworthFSFCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
-            case( bessel ):
-                for ( int s = 0; s < m_nStages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setFrequency( m_f0 * besselFSFCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
-            case( chebyshev ):
-                for ( int s = 0; s < m_nStages; s++ )
-                {
-                    //                    DBG( "stage " << s );
-                    cascade[ s ].setFrequency( m_f0 * chebyshev1dbFSFCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
-            default:
-                for ( int s = 0; s < m_nStages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setFrequency( m_f0 * butterworthFSFCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
+            m_stages[ s ].setCoefficients( m_coeffs[ s ] );
         }
     }
-    
+
     void setFilterType( int type )
     {
-        for ( int i = 0; i < cascade.size(); i++ )
+        if ( m_type != type )
         {
-//            if ( cascade[ i ].getFilterType)
-            cascade[ i ].setFilterType( type );
+            clear();
         }
+        m_type = type;
+        m_calculator.setFilterType( type );
         setFrequency( m_f0 );
     }
 
-    
+    void clear()
+    {
+        for ( auto& s : m_stages )
+        {
+            s.clear();
+        }
+    }
+
+
     enum filterDesign
     {
-        butterworth = 1, bessel, chebyshev
+        butterworth = 1, bessel, chebyshev, linkwitzRiley
     };
-   
+
 private:
-    
-    void setQFactors()
+
+    const sjf::filters::cascadeDesign::stages& getDesign()
     {
-        auto stages = cascade.size();
         switch ( m_design )
         {
-            case( butterworth ):
-                for ( int s = 0; s < stages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setQFactor( butterworthQCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
             case( bessel ):
-                for ( int s = 0; s < stages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setQFactor( besselQCoefficients[ s ][ m_nOrders - 1 ] );
-                }
-                break;
+                return sjf::filters::cascadeDesign::besselTable[ m_nOrders - 1 ];
             case( chebyshev ):
-                for ( int s = 0; s < stages; s++ )
-                {
-                    //                    DBG( "stage " << s );
-                    cascade[ s ].setQFactor( chebyshev1dbQCoefficients[ s ][ m_nOrders - 1 ] );
-                }
+                return sjf::filters::cascadeDesign::chebyshevTable[ m_nOrders - 1 ];
+            case( linkwitzRiley ):
+                return sjf::filters::cascadeDesign::linkwitzRileyTable[ m_nOrders - 1 ];
+            default:
+                return sjf::filters::cascadeDesign::butterworthTable[ m_nOrders - 1 ];
+        }
+    }
+
+    void updateDesign()
+    {
+        auto nStages = getDesign().nStages;
+        for ( int s = m_nStages; s < nStages; s++ )
+        {
+            m_stages[ s ].clear();
+        }
+        m_nStages = nStages;
+        setFrequency( m_f0 );
+    }
+
+    void calculateCoefficients()
+    {
+        switch ( m_type )
+        {
+            case sjf_biquadCalculator< T >::lowpass:
+                calculatePassCoefficients< false >();
+                break;
+            case sjf_biquadCalculator< T >::highpass:
+                calculatePassCoefficients< true >();
                 break;
             default:
-                for ( int s = 0; s < stages; s++ )
-                {
-//                    DBG( "stage " << s );
-                    cascade[ s ].setQFactor( butterworthQCoefficients[ s ][ m_nOrders - 1 ] );
-                }
+                calculateCoefficientsPerStage();
                 break;
         }
-    
-        
+    }
 
+    // the whole prototype is prewarped once at the cutoff ( one tan() ) and each stage is scaled from there,
+    // every stage ( used or not ) is calculated with the same arithmetic so the loops vectorise
+    // the first order stage of an odd order design is overwritten at the end
+    template < bool isHighpass >
+    void calculatePassCoefficients()
+    {
+        const auto& design = getDesign();
+        const T maxF = m_SR * 0.49;
+        const T K0 = std::tan( ( m_f0 < maxF ? m_f0 : maxF ) * m_angFreqFactor );
+        for ( int s = 0; s < MAX_NUM_STAGES; s++ )
+        {
+            m_K[ s ] = isHighpass ? K0 / static_cast< T >( design.fsf[ s ] ) : K0 * static_cast< T >( design.fsf[ s ] );
+        }
+        for ( int s = 0; s < MAX_NUM_STAGES; s++ )
+        {
+            T K = m_K[ s ];
+            T Q = static_cast< T >( design.q[ s ] );
+            T K2 = K * K;
+            T K2Q = K2 * Q;
+            T denominatorReciprocal = 1.0 / ( K2Q + K + Q );
+            T num = ( isHighpass ? Q : K2Q ) * denominatorReciprocal;
+            m_b0[ s ] = num;
+            m_b1[ s ] = ( isHighpass ? -2.0 : 2.0 ) * num;
+            m_a1[ s ] = 2.0 * Q * ( K2 - 1.0 ) * denominatorReciprocal;
+            m_a2[ s ] = ( K2Q - K + Q ) * denominatorReciprocal;
+        }
+        for ( int s = 0; s < m_nStages; s++ )
+        {
+            m_coeffs[ s ] = { m_b0[ s ], m_b1[ s ], m_b0[ s ], m_a1[ s ], m_a2[ s ] };
+        }
+        if ( design.firstOrderLast )
+        {
+            auto s = m_nStages - 1;
+            T K = m_K[ s ];
+            T denominatorReciprocal = 1.0 / ( K + 1.0 );
+            T b0 = ( isHighpass ? 1.0 : K ) * denominatorReciprocal;
+            m_coeffs[ s ] = { b0, isHighpass ? -b0 : b0, 0, ( K - 1 ) * denominatorReciprocal, 0 };
+        }
+        for ( int i = 0; i < 3; i++ )
+            m_coeffs[ 0 ][ i ] *= static_cast< T >( design.gain );
     }
-    
-    // coefficients for butterworth filters of up to 10 orders
-    // [ stage ] [ order ]
-    // just for avoiding any possible divide by 0 I have set default values (i.e. not in use values) to '1'
-    // from https://www.researchgate.net/publication/264896983_An_UHF_frequency-modulated_continuous_wave_wind_profiler-receiver_and_audio_module_development
-    static constexpr T butterworthQCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
+
+    void calculateCoefficientsPerStage()
     {
-        { 0.7071, 0.7071, 1, 0.5412, 0.618, 0.5176, 0.555, 0.5098, 0.5321, 0.5062 }, // stage 1
-        { 1, 1, 1, 1.3065, 1.6182, 0.7071, 0.8019, 0.6013, 0.6527, 0.5612 }, // stage 2
-        { 1, 1, 1, 1, 1, 1.9319, 2.2471, 0.9, 1, 0.7071 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 1, 2.5628, 2.8785, 1.1013 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 3.197 } // stage 5
-    };
-    
-    static constexpr T butterworthFSFCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-    { // table didn't give first order...
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, // stage 1
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, // stage 2
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 } // stage 5
-    };
-    
-//    static constexpr T besselQCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-//    { // table didn't give first order...
-//        { 1, 0.5773, 0.6910, 0.5219, 0.5635, 0.5103, 0.5324, 0.5060, 0.5197, 0.5040 }, // stage 1
-//        { 1, 1, 1, 0.8055, 0.9165, 0.6112, 0.6608, 1.2258, 0.5894, 0.5380 }, // stage 2
-//        { 1, 1, 1, 1, 1, 1.0234, 1.1262, 0.7109, 0.7606, 0.6200 }, // stage 3
-//        { 1, 1, 1, 1, 1, 1, 1, 0.5596, 1.3220, 0.8100 }, // stage 4
-//        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.4150 } // stage 5
-//    };
-//
-//    static constexpr T besselFSFCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-//    { // table didn't give first order...
-//        { 1, 1.2736, 1.4524, 1.4192, 1.5611, 1.6060, 1.7174, 1.7837, 1.8794, 1.9490 }, // stage 1
-//        { 1, 1, 1.3270, 1.5912, 1.7607, 1.6913, 1.8235, 2.1953, 1.9488, 1.9870 }, // stage 2
-//        { 1, 1, 1, 1, 1.5069, 1.9071, 2.0507, 1.9591, 2.0815, 2.0680 }, // stage 3
-//        { 1, 1, 1, 1, 1, 1, 1.6853, 1.8376, 2.3235, 2.2210 }, // stage 4
-//        { 1, 1, 1, 1, 1, 1, 1, 1, 1.8575, 2.4850 } // stage 5
-//    };
-    static constexpr T besselQCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-    { // table didn't give first order...
-        { 1, 0.5771, 0.6910, 0.5219, 0.5635, 0.5103, 0.5324, 0.5060, 0.5197, 0.5040 }, // stage 1
-        { 1, 1, 1, 0.8055, 0.9165, 0.6112, 0.6608, 1.2258, 0.5894, 0.5380 }, // stage 2
-        { 1, 1, 1, 1, 1, 1.0234, 1.1262, 0.7109, 0.7606, 0.6205 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 1, 0.5597, 1.3220, 0.8100 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 1.4150 } // stage 5
-    };
-    
-    static constexpr T besselFSFCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-    { // table didn't give first order...
-        { 1, 1.2754, 1.4524, 1.4192, 1.5611, 1.6060, 1.7174, 1.7838, 1.8794, 1.9490 }, // stage 1
-        { 1, 1, 1.3270, 1.5912, 1.7607, 1.6913, 1.8235, 2.1953, 1.9488, 1.9870 }, // stage 2
-        { 1, 1, 1, 1, 1.5069, 1.9071, 2.0507, 1.9591, 2.0815, 2.0678 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 1.6853, 1.8378, 2.3235, 2.2210 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1.8575, 2.4850 } // stage 5
-    };
+        const auto& design = getDesign();
+        for ( int s = 0; s < m_nStages; s++ )
+        {
+            m_calculator.setOrder( design.firstOrderLast && s == m_nStages - 1 );
+            m_calculator.setQFactor( design.q[ s ] );
+            m_calculator.setFrequency( m_f0 * design.fsf[ s ] );
+            m_coeffs[ s ] = m_calculator.getCoefficients();
+        }
+    }
 
-//    static constexpr T chebyshev1dbQCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-//    { // table didn't give first order...
-//        { 1, 0.9565, 2.0176, 0.7845, 1.3988, 0.7608, 1.2967, 0.7530, 1.1964, 0.7495 }, // stage 1
-//        { 1, 1, 1, 3.5600, 5.5538, 2.1977, 3.1544, 1.9564, 2.7119, 1.8639 }, // stage 2
-//        { 1, 1, 1, 1, 1, 8.0012, 10.9010, 2.7776, 5.5239, 3.5609 }, // stage 3
-//        { 1, 1, 1, 1, 1, 1, 1, 14.2445, 18.0069, 6.9419 }, // stage 4
-//        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 22.2779 } // stage 5
-//    };
-
-    static constexpr T chebyshev1dbQCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-    { // table didn't give first order...
-        { 1, 0.9564, 2.0173, 0.7845, 1.3988, 0.7608, 1.2961, 0.7530, 1.2597, 0.7496 }, // stage 1
-        { 1, 1, 1, 3.5594, 5.5559, 2.3462, 3.1558, 1.9560, 2.7129, 1.8645 }, // stage 2
-        { 1, 1, 1, 1, 1, 8.0036, 10.8982, 4.2657, 5.5628, 3.5597 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 1, 14.2391, 18.0226, 6.9374 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 1, 22.2916 } // stage 5
-    };
-//    static constexpr T chebyshev1dbFSFCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-//    { // table didn't give first order...
-//        { 1, 1.0500, 0.9971, 0.9932, 0.9941, 0.9953, 0.9963, 0.9971, 0.9976, 0.9981 }, // stage 1
-//        { 1, 1, 0.4942, 0.5286, 0.6652, 0.7468, 0.8084, 0.5538, 0.8805, 0.7214 }, // stage 2
-//        { 1, 1, 1, 1, 0.2895, 0.3532, 0.4800, 0.5838, 0.6623, 0.9024 }, // stage 3
-//        { 1, 1, 1, 1, 1, 1, 0.2054, 0.2651, 0.3812, 0.4760 }, // stage 4
-//        { 1, 1, 1, 1, 1, 1, 1, 1, 0.1593, 0.2121 } // stage 5
-//    };
-
-    static constexpr T chebyshev1dbFSFCoefficients[ MAX_NUM_STAGES ][ MAX_ORDER ] =
-    { // table didn't give first order...
-        { 1, 0.8623, 0.9106, 0.5109, 0.6337, 0.3451, 0.4719, 0.2616, 0.3734, 0.2103 }, // stage 1
-        { 1, 1, 0.4513, 0.9433, 0.9614, 0.7273, 0.7946, 0.5762, 0.6554, 0.4721 }, // stage 2
-        { 1, 1, 1, 1, 0.2800, 0.9726, 0.9795, 0.8395, 0.8715, 0.7155 }, // stage 3
-        { 1, 1, 1, 1, 1, 1, 0.2019, 0.9842, 0.9873, 0.8949 }, // stage 4
-        { 1, 1, 1, 1, 1, 1, 1, 1, 0.1577, 0.9897 } // stage 5
-    };
-    
-    
-    std::array< sjf_biquadWrapper < T >, MAX_NUM_STAGES > cascade;
+    std::array< sjf_biquad < T >, MAX_NUM_STAGES > m_stages;
+    std::array< std::array< T, 5 >, MAX_NUM_STAGES > m_coeffs;
+    std::array< T, MAX_NUM_STAGES > m_K, m_b0, m_b1, m_a1, m_a2;
+    sjf_biquadCalculator< T > m_calculator;
     int m_nOrders = 3, m_nStages = 2;
     int m_design = filterDesign::butterworth;
-    T m_f0 = 1000;
+    int m_type = sjf_biquadCalculator< T >::lowpass;
+    T m_f0 = 1000, m_SR = 44100, m_angFreqFactor = M_PI / m_SR;
+    int m_modInterval = 32, m_modCount = 0;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_biquadCascade )
 };
 
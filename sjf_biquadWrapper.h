@@ -34,6 +34,33 @@ public:
         }
     }
     
+    // uses an approximation of tan() for the prewarping so it is cheap enough to call every sample when modulating the cutoff
+    void setFrequencyApprox( T f )
+    {
+        if ( m_calculator.getFrequency() != f )
+        {
+            m_calculator.setFrequencyApprox( f );
+            m_biquad.setCoefficients( m_calculator.getCoefficients() );
+        }
+    }
+    
+    // exact coefficients are calculated for f, but the filter moves to them linearly over the next nSamples calls to filterInputRamped()
+    void setFrequencyRamped( T f, int nSamples )
+    {
+        if ( m_calculator.getFrequency() != f )
+        {
+            m_calculator.setFrequency( f );
+            m_biquad.setCoefficientsRamped( m_calculator.getCoefficients(), nSamples );
+        }
+    }
+    
+    // number of samples between exact coefficient calculations when using filterInput( input, frequency )
+    void setModulationInterval( int nSamples )
+    {
+        m_modInterval = nSamples > 0 ? nSamples : 1;
+        m_modCount = 0;
+    }
+    
     T getFrequency()
     {
         return m_calculator.getFrequency();
@@ -78,7 +105,7 @@ public:
         }
     }
     
-    std::vector< T > getCoefficients()
+    const std::array< T, 5 >& getCoefficients()
     {
         return m_calculator.getCoefficients();
     }
@@ -118,6 +145,24 @@ public:
         return m_biquad.filterInput( input );
     }
     
+    T filterInputRamped( T input )
+    {
+        return m_biquad.filterInputRamped( input );
+    }
+    
+    // for audio rate modulation of the cutoff
+    // the coefficients are only calculated every m_modInterval samples ( see setModulationInterval() ) and ramped in between
+    T filterInput( T input, T f )
+    {
+        if ( m_modCount == 0 )
+        {
+            m_modCount = m_modInterval;
+            setFrequencyRamped( f, m_modInterval );
+        }
+        --m_modCount;
+        return m_biquad.filterInputRamped( input );
+    }
+    
     void clear()
     {
         m_biquad.clear();
@@ -126,6 +171,7 @@ public:
 private:
     sjf_biquad< T > m_biquad;
     sjf_biquadCalculator< T > m_calculator;
+    int m_modInterval = 32, m_modCount = 0;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_biquadWrapper )
 };
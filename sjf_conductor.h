@@ -8,11 +8,11 @@
 #define sjf_conductor_h
 
 #include <JuceHeader.h>
+#include <array>
+#include <cmath>
 
 // class to act as rhythmic generator for sequence based devices
 //                  TO DO
-// -- Improve rhythmic accuracy using sample based logic (as per gransynth)
-//          -- output new triggers at sample point
 // -- Possibly incorporate AAIM rhythm gen style logic
 // -- Create enums for division and tuplet type
 class sjf_conductor
@@ -24,7 +24,7 @@ public:
     ~sjf_conductor(){}; // default destructor
     //==============================================================================
     // simple calculation of current step based on host position
-    // NOTE:not sample accurate so limited to block size!
+    // NOTE:not sample accurate so limited to block size! ( see calculateStepEvents )
     int getCurrentStep( double hostPosition )
     {
         if (!m_isOnFlag){ return -1; }
@@ -35,6 +35,53 @@ public:
     // output of current step for GUI display
     int getCurrentStep(){ return m_currentStep; }
     //==============================================================================
+    // a step that starts part way through a block
+    struct stepEvent
+    {
+        int sampleOffset; // first sample of the block that belongs to the new step
+        int step;
+    };
+    static constexpr int MAX_EVENTS_PER_BLOCK = 256;
+    //==============================================================================
+    // sample accurate version of getCurrentStep
+    // finds every step boundary between the host position at the start of the block and the end of the block
+    // the results are in order of sampleOffset and can be read with getNumStepEvents() / getStepEvent()
+    // so a block can be split at each event rather than only checking the step once per block
+    // ppqPosition is the host position in quarter notes at the first sample of the block
+    // returns the number of events
+    int calculateStepEvents( double ppqPosition, double bpm, double sampleRate, int blockSize )
+    {
+        m_nEvents = 0;
+        if ( !m_isOnFlag || bpm <= 0 || sampleRate <= 0 || blockSize <= 0 ){ return 0; }
+        const auto stepsPerQuarter = static_cast< double >( m_div ) * m_tuplet;
+        const auto samplesPerStep = 60.0 * sampleRate / ( bpm * stepsPerQuarter );
+        const auto stepPosition = ppqPosition * stepsPerQuarter; // position in steps at the start of the block
+        // a boundary is triggered at the first sample on or after it, so one just before the block starts still belongs to this block
+        // hosts report positions with some rounding so this looks back 2 samples, anything already triggered at the end of the last block is skipped
+        constexpr auto tolerance = 1e-6;
+        auto boundary = static_cast< long long >( std::ceil( stepPosition - 2.0 / samplesPerStep ) );
+        if ( boundary <= m_lastBoundary && boundary > m_lastBoundary - 2 ){ boundary = m_lastBoundary + 1; }
+        while ( m_nEvents < MAX_EVENTS_PER_BLOCK )
+        {
+            auto offset = static_cast< int >( std::ceil( ( boundary - stepPosition ) * samplesPerStep - tolerance ) );
+            offset = offset < 0 ? 0 : offset;
+            if ( offset >= blockSize ){ break; }
+            m_events[ m_nEvents++ ] = { offset, wrapStep( boundary ) };
+            m_lastBoundary = boundary;
+            ++boundary;
+        }
+        // step that is sounding at the end of the block
+        m_currentStep = wrapStep( static_cast< long long >( std::floor( stepPosition + ( blockSize - 1 ) / samplesPerStep + tolerance ) ) );
+        return m_nEvents;
+    }
+    //==============================================================================
+    int getNumStepEvents() const { return m_nEvents; }
+    //==============================================================================
+    const stepEvent& getStepEvent( int index ) const { return m_events[ index ]; }
+    //==============================================================================
+    // forget the last step triggered, e.g. when playback stops or the host jumps
+    void resetStepEvents(){ m_lastBoundary = NO_BOUNDARY; m_nEvents = 0; }
+    //==============================================================================
     // sets the rhythmic division type
     void setDivision( int rhythmicDivision )
     {
@@ -70,6 +117,16 @@ public:
     bool isOn(){ return m_isOnFlag; } // returns whether the conductor is on/off
     //==============================================================================
 private:
+    int wrapStep( long long stepCount ) const
+    {
+        auto step = static_cast< int >( stepCount % m_nSteps );
+        return step < 0 ? step + m_nSteps : step;
+    }
+    //==============================================================================
+    static constexpr long long NO_BOUNDARY = -( 1LL << 62 );
+    std::array< stepEvent, MAX_EVENTS_PER_BLOCK > m_events;
+    int m_nEvents = 0;
+    long long m_lastBoundary = NO_BOUNDARY;
     int m_nSteps = 32; // default number of steps
     int m_currentStep; // used to keep track of count
     float m_div = 1; // the rhythmic division value
@@ -16,6 +16,7 @@
 #include "sjf_delayLine.h"
 #include "sjf_buffir2.h" // this uses Apple Accelerate framework
 #include "sjf_lpf.h"
+#include "sjf_sampleLoader.h"
 #include <JuceHeader.h>
 
 
@@ -34,6 +35,19 @@ public:
     {
         m_trimFlag = shouldTrimImpulse;
         m_formatManager.registerBasicFormats();
+        m_loader.setPublishesToSlots( false ); // kernels are handed to the audio thread separately and m_cachedSample keeps the data
+        m_loader.onLoaded = [ this ]( size_t, sjf::sampleCache::samplePtr data, const juce::File& file )
+        {
+            if ( data == nullptr ){ return; }
+            m_IRSampleRate = data->getSampleRate();
+            m_impulseBufferOriginal = data->getBuffer(); // refers to the shared data, never written to
+            m_cachedSample = data;
+            m_samplePath = file.getFullPathName();
+            m_sampleName = file.getFileName();
+            m_impulseChangedFlag = true;
+            m_impulseLoadedFlag = true;
+            setImpulseResponse();
+        };
         for ( int c = 0; c < NUM_CHANNELS; c++ )
         {
             m_lpf[ c ].setCutoff( 0.999f );
@@ -62,26 +76,18 @@ public:
         {
             m_preDelay[ c ].initialise( sampleRate );
         }
+        // impulses are converted to the session rate when they are loaded (the FIR section can't compensate for a different rate)
+        if ( m_loader.getTargetSampleRate() == sampleRate ){ return; }
+        m_loader.setTargetSampleRate( sampleRate );
+        if ( m_impulseLoadedFlag ){ m_loader.load( 0, juce::File( m_samplePath ) ); }
     }
     //==============================================================================
+    /** the impulse is decoded on a background thread and set once it has finished */
     void loadSample( juce::Value path )
     {
         juce::File file( path.getValue().toString() );
         if (file == juce::File{}) { return; }
-        std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-        if (reader.get() != nullptr)
-        {
-            auto nSamps = static_cast<int>(reader->lengthInSamples);
-            auto nChannels = static_cast<int>(reader->numChannels);
-            m_IRSampleRate = reader->sampleRate;
-            m_impulseBufferOriginal.setSize( nChannels, nSamps );
-            reader->read (&m_impulseBufferOriginal, 0, nSamps, 0, true, true);
-            m_samplePath = file.getFullPathName();
-            m_sampleName = file.getFileName();
-            m_impulseChangedFlag = true;
-            m_impulseLoadedFlag = true;
-            setImpulseResponse();
-        }
+        m_loader.load( 0, file );
     }
     //------------------------------------------------//------------------------------------------------
     void loadImpulse()
@@ -95,25 +101,13 @@ public:
                                 {
                                     auto file = fc.getResult();
                                     if (file == juce::File{}) { return; }
-                                    std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-                                    if (reader.get() != nullptr)
-                                    {
-                                        auto nSamps = static_cast<int>(reader->lengthInSamples);
-                                        auto nChannels = static_cast<int>(reader->numChannels);
-                                        m_IRSampleRate = reader->sampleRate;
-                                        m_impulseBufferOriginal.setSize( nChannels, nSamps );
-                                        reader->read (&m_impulseBufferOriginal, 0, nSamps, 0, true, true);
-                                        m_samplePath = file.getFullPathName();
-                                        m_sampleName = file.getFileName();
-                                        m_impulseChangedFlag = true;
-                                        m_impulseLoadedFlag = true;
-                                        setImpulseResponse();
-                                    }
+                                    m_loader.load( 0, file );
                                 });
     }
     //------------------------------------------------//------------------------------------------------
     void process( juce::AudioBuffer<float> &buffer )
     {
+        applyPendingKernels();
         if ( m_impulseBuffer.getNumChannels() < 1 )
         {
             return;
@@ -476,22 +470,26 @@ private:
         auto nSamps = buffer.getNumSamples();
         auto nChannels  = buffer.getNumChannels();
         
-        
+        // kernels are handed to the audio thread at the start of the next block rather than written while it might be reading them
+        while( m_kernelBusy.test_and_set() ){ } // WAIT for audio thread to finish copying
         for ( int c = 0; c < NUM_CHANNELS; c++ )
         {
-            m_FIR[ c ].clear();
-            if ( nSamps <= 0 ){ return; }
-            m_FIR[ c ].setKernel( buffer.getWritePointer( c % nChannels, 0 ), nSamps );
+            for ( int i = 0; i < FIR_BUFFER_SIZE; i++ )
+            {
+                m_pendingKernel[ c ][ i ] = ( i < nSamps && nChannels > 0 ) ? buffer.getSample( c % nChannels, i ) : 0;
+            }
         }
+        m_pendingFFTFlag = nSamps > FIR_BUFFER_SIZE;
+        m_kernelPending = true;
+        m_kernelBusy.clear();
+        if ( nSamps <= 0 ){ return; }
         
         m_conv.reset();
         if ( nSamps <= FIR_BUFFER_SIZE )
         {
-            m_fftFlag = false;
             return;
         }
         
-        m_fftFlag = true;
         m_fftImpulseBuffer.setSize( NUM_CHANNELS, nSamps - FIR_BUFFER_SIZE );
         for ( int c = 0; c < NUM_CHANNELS; c++ )
         {
@@ -501,6 +499,21 @@ private:
         m_conv.reset();
     }
     //------------------------------------------------//------------------------------------------------
+    // AUDIO THREAD --> copy across any kernels set since the last block
+    void applyPendingKernels()
+    {
+        if ( !m_kernelPending.load() ){ return; }
+        if ( m_kernelBusy.test_and_set() ){ return; } // kernels are being written, try again next block
+        for ( int c = 0; c < NUM_CHANNELS; c++ )
+        {
+            m_FIR[ c ].clear();
+            m_FIR[ c ].setKernel( m_pendingKernel[ c ].data() );
+        }
+        m_fftFlag = m_pendingFFTFlag;
+        m_kernelPending = false;
+        m_kernelBusy.clear();
+    }
+    //------------------------------------------------//------------------------------------------------
     
     std::array< sjf_delayLine< float >, NUM_CHANNELS > m_preDelay;
     std::array< sjf_buffir< FIR_BUFFER_SIZE >, NUM_CHANNELS > m_FIR;
@@ -519,7 +532,13 @@ private:
     double m_IRSampleRate = 0;
     juce::String m_samplePath, m_sampleName;
     juce::AudioFormatManager m_formatManager;
+    sjf::sampleCache::asyncLoader m_loader{ m_formatManager };
     std::unique_ptr<juce::FileChooser> m_chooser;
+    sjf::sampleCache::samplePtr m_cachedSample; // keeps the shared data m_impulseBufferOriginal refers to alive
+    std::array< std::array< float, FIR_BUFFER_SIZE >, NUM_CHANNELS > m_pendingKernel;
+    bool m_pendingFFTFlag = false;
+    std::atomic< bool > m_kernelPending{ false };
+    std::atomic_flag m_kernelBusy = ATOMIC_FLAG_INIT;
     std::array< sjf_lpf< float >, NUM_CHANNELS > m_lpf, m_hpf;
     
     std::vector< std::array< float, 2 > > m_env { {0,0}, {0,1}, {1,1}, {1,0} }; // normalised amplitude envelope envPoint{ position0to1, amplitude0to1 }
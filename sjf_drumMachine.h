@@ -8,6 +8,9 @@
 #define sjf_drumMachine_h
 
 #include <vector>
+#include <array>
+#include <limits>
+#include <algorithm>
 #include <JuceHeader.h>
 #include "sjf_audioUtilities.h"
 #include "sjf_oneshot.h"
@@ -31,6 +34,8 @@ public:
     
     void initialise(int sampleRate, int totalNumOutputChannels, int samplesPerBlock)
     {
+        m_SR = sampleRate;
+        m_fadeLenSamps = std::max( 1, static_cast< int >( std::round( m_SR * 0.001 ) ) ); // 1ms, the same as sjf_oneshot
         for (int v = 0; v < m_nVoices; v++)
         {
             samples[v]->initialise(sampleRate);
@@ -67,6 +72,46 @@ public:
         m_lastStep = step;
     }
     
+    // sample accurate, event driven version of runMachine
+    // each step that starts in the block starts a hit at its sample offset, only hits that are actually sounding are rendered
+    // ( each as one run of samples with its gain and pan ), so the cost depends on the number of hits rather than the size of the kit
+    // retriggering a voice fades out its last hit over 1ms, the same as sjf_oneshot
+    // ppqPosition is the host position in quarter notes at the start of the block
+    // call resetSteps() when the host stops or jumps so the first step is triggered again
+    void runMachine(juce::AudioBuffer< float > &buffer, int totalNumOutputChannels, double ppqPosition, double bpm)
+    {
+        auto buffSize = buffer.getNumSamples();
+        for (int v = 0; v < m_nVoices; v++){ samples[v]->updateLoadedSample(); }
+        auto nEvents = conductor.calculateStepEvents( ppqPosition, bpm, m_SR, buffSize );
+        for (int e = 0; e < nEvents; e++)
+        {
+            const auto& event = conductor.getStepEvent( e );
+            for (int v = 0; v < m_nVoices; v++)
+            {
+                if ( m_stepVector[event.step][v] && samples[v]->getSampleBuffer() != nullptr ){ startHit( v, event.sampleOffset ); }
+            }
+            m_lastStep = event.step;
+        }
+        auto nOutChannels = std::min( totalNumOutputChannels, buffer.getNumChannels() );
+        for (auto& h : m_hits)
+        {
+            if ( h.active ){ renderHit( h, buffer.getArrayOfWritePointers(), nOutChannels, buffSize ); }
+        }
+    }
+    
+    // number of hits currently sounding
+    int getNumActiveHits() const
+    {
+        auto n = 0;
+        for (auto& h : m_hits){ n += h.active ? 1 : 0; }
+        return n;
+    }
+    
+    void resetSteps(){ conductor.resetStepEvents(); m_lastStep = -1; }
+    
+    // stop every hit straight away
+    void clearHits(){ for (auto& h : m_hits){ h.active = false; } }
+    
     void turnOn( bool state) { conductor.turnOn(state); }
     int getNumVoices(){ return m_nVoices; }
     int getMaxNumSteps(){ return m_nSteps; }
@@ -79,7 +124,7 @@ public:
     void setTuplet( int newTuplet ){ m_tupletType = newTuplet; conductor.setTuplet( m_tupletType ); }
     bool isOn(){ return conductor.isOn(); }
     bool getStepVoiceState( int step, int voice ){ return m_stepVector[step][voice]; }
-    juce::String getSampleName( int voiceNumber ){ return samples[voiceNumber]->m_samplePath.getFileName(); }
+    juce::String getSampleName( int voiceNumber ){ return samples[voiceNumber]->getFileName(); }
     int getDivisionType(){ return m_divisionType; }
     int getTupletType(){ return m_tupletType; }
     float getGain( int voice ){ return samples[ voice ]->getGain(); }
@@ -87,7 +132,75 @@ public:
     float getPan( int voice ){ return samples[ voice ]->getPan(); }
     void setPan( int voice, float pan ){ samples[ voice ]->setPan( pan ); }
 private:
+    //==============================================================================
+    // one playing instance of a voice's sample, the pool is fixed so triggering never allocates
+    struct hit
+    {
+        int voice = 0, readPos = 0, startOffset = 0, fadeStart = NOT_FADING, fadePos = 0;
+        bool active = false;
+    };
+    static constexpr int MAX_HITS = 64, NOT_FADING = std::numeric_limits< int >::max();
+    //==============================================================================
+    void startHit( int voice, int offset )
+    {
+        // fade out anything this voice is already playing
+        for (auto& h : m_hits)
+        {
+            if ( h.active && h.voice == voice && h.fadeStart == NOT_FADING ){ h.fadeStart = std::max( offset, h.startOffset ); }
+        }
+        // take a free hit, or steal the one that has been playing longest
+        auto* newHit = &m_hits[ 0 ];
+        for (auto& h : m_hits)
+        {
+            if ( !h.active ){ newHit = &h; break; }
+            if ( h.readPos > newHit->readPos ){ newHit = &h; }
+        }
+        *newHit = hit{};
+        newHit->voice = voice;
+        newHit->startOffset = offset;
+        newHit->active = true;
+    }
+    //==============================================================================
+    void renderHit( hit& h, float* const* out, int nOutChannels, int blockSize )
+    {
+        auto* source = samples[ h.voice ]->getSampleBuffer();
+        if ( source == nullptr || h.readPos >= source->getNumSamples() ){ h.active = false; return; }
+        auto nSourceChannels = source->getNumChannels();
+        auto sourceLength = source->getNumSamples();
+        // only gain, like sjf_oneshot::playOneShot(), the voice's pan setting has never been applied to the output
+        auto gain = samples[ h.voice ]->getGain();
+        
+        auto start = h.startOffset;
+        auto end = std::min( blockSize, start + ( sourceLength - h.readPos ) );
+        auto fadeStart = std::min( std::max( h.fadeStart, start ), end );
+        auto fadeEnd = h.fadeStart == NOT_FADING ? end : std::min( end, fadeStart + ( m_fadeLenSamps - h.fadePos ) );
+        for (int c = 0; c < nOutChannels; c++)
+        {
+            auto* src = source->getReadPointer( c % nSourceChannels ) + h.readPos;
+            auto* dest = out[ c ] + start;
+            auto nFull = fadeStart - start, nFade = fadeEnd - fadeStart;
+            for (int i = 0; i < nFull; i++){ dest[ i ] += src[ i ] * gain; }
+            src += nFull;
+            dest += nFull;
+            auto fadeInc = gain / m_fadeLenSamps, fadeGain = gain - fadeInc * h.fadePos;
+            for (int i = 0; i < nFade; i++){ dest[ i ] += src[ i ] * ( fadeGain - fadeInc * i ); }
+        }
+        h.readPos += ( h.fadeStart == NOT_FADING ? end : fadeEnd ) - start;
+        h.startOffset = 0;
+        if ( h.fadeStart != NOT_FADING )
+        {
+            h.fadePos += fadeEnd - fadeStart;
+            h.fadeStart = 0;
+            if ( h.fadePos >= m_fadeLenSamps ){ h.active = false; }
+        }
+        if ( h.readPos >= sourceLength ){ h.active = false; }
+    }
+    //==============================================================================
+    
     sjf_conductor conductor;
+    double m_SR = 44100;
+    int m_fadeLenSamps = 44;
+    std::array< hit, MAX_HITS > m_hits;
     int m_nVoices = 10, m_nSteps = 32, m_lastStep = -1, m_nPatSteps = 32, m_divisionType = 2, m_tupletType = 1;
     std::vector< std::vector< bool > >  m_stepVector;
     
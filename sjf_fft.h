@@ -0,0 +1,126 @@
+//
+//  sjf_fft.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_fft_h
+#define sjf_fft_h
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cassert>
+#include <utility>
+
+namespace sjf::spectral
+{
+    /**
+     In place radix 2 complex fft
+     The twiddle factors and bit reversal swaps are calculated in prepare(), after that perform() does not allocate so it can be used on the audio thread
+     The inverse is not scaled, divide by getSize() to get back to the original signal
+     Complex multiplies are written out by hand, std::complex's checks for infinities are very slow without -ffast-math
+     */
+    template< typename Sample >
+    class fft
+    {
+    public:
+        using complex = std::complex< Sample >;
+
+        fft(){}
+        ~fft(){}
+
+        /** size must be a power of 2, allocates so NOT on the audio thread */
+        void prepare( size_t size )
+        {
+            assert( size >= 2 && ( size & ( size - 1 ) ) == 0 );
+            m_size = size;
+            // the twiddles of each stage are stored one after the other ( the stage with half = h starts at h - 1 ) so the butterflies read them in order
+            m_twiddles.resize( size - 1 );
+            for ( size_t half = 1; half < size; half <<= 1 )
+            {
+                for ( size_t k = 0; k < half; ++k )
+                {
+                    auto angle = -M_PI * static_cast< double >( k ) / static_cast< double >( half );
+                    m_twiddles[ half - 1 + k ] = complex( static_cast< Sample >( std::cos( angle ) ), static_cast< Sample >( std::sin( angle ) ) );
+                }
+            }
+            // only the pairs that actually need swapping are stored, so the reordering has no branches
+            m_swaps.clear();
+            for ( size_t i = 0, j = 0; i < size; ++i )
+            {
+                if ( i < j )
+                    m_swaps.emplace_back( i, j );
+                auto bit = size >> 1;
+                for ( ; j & bit; bit >>= 1 )
+                    j ^= bit;
+                j ^= bit;
+            }
+        }
+
+        size_t getSize() const { return m_size; }
+
+        /** transform getSize() values in place */
+        void perform( complex* data, bool inverse ) const
+        {
+            const auto n = m_size;
+            for ( const auto& [ i, j ] : m_swaps )
+                std::swap( data[ i ], data[ j ] );
+            // the first stage has no multiplies
+            for ( size_t i = 0; i < n; i += 2 )
+            {
+                const auto a = data[ i ], b = data[ i + 1 ];
+                data[ i ] = a + b;
+                data[ i + 1 ] = a - b;
+            }
+            // std::complex is guaranteed to be laid out as { real, imag } so the butterflies work on the raw values
+            auto* d = reinterpret_cast< Sample* >( data );
+            const auto* tw = reinterpret_cast< const Sample* >( m_twiddles.data() );
+            // the inverse uses the conjugate twiddles
+            const Sample sign = inverse ? -1 : 1;
+            for ( size_t half = 2; half < n; half <<= 1 )
+            {
+                const auto* w = tw + 2 * ( half - 1 );
+                for ( size_t i = 0; i < n; i += 2 * half )
+                {
+                    auto* a = d + 2 * i;
+                    auto* b = a + 2 * half;
+                    for ( size_t k = 0; k < half; ++k )
+                    {
+                        const auto wr = w[ 2 * k ], wi = sign * w[ 2 * k + 1 ];
+                        const auto br = b[ 2 * k ], bi = b[ 2 * k + 1 ];
+                        const auto vr = br * wr - bi * wi;
+                        const auto vi = br * wi + bi * wr;
+                        const auto ar = a[ 2 * k ], ai = a[ 2 * k + 1 ];
+                        a[ 2 * k ] = ar + vr;
+                        a[ 2 * k + 1 ] = ai + vi;
+                        b[ 2 * k ] = ar - vr;
+                        b[ 2 * k + 1 ] = ai - vi;
+                    }
+                }
+            }
+        }
+
+        void perform( std::vector< complex >& data, bool inverse ) const
+        {
+            assert( data.size() >= m_size );
+            perform( data.data(), inverse );
+        }
+
+    private:
+        size_t m_size = 0;
+        std::vector< complex > m_twiddles;
+        std::vector< std::pair< size_t, size_t > > m_swaps;
+    };
+
+    /** smallest power of 2 that is at least n */
+    inline size_t nextPowerOf2( size_t n )
+    {
+        size_t p = 1;
+        while ( p < n )
+            p <<= 1;
+        return p;
+    }
+}
+
+#endif /* sjf_fft_h */
@@ -12,6 +12,9 @@
 #include "sjf_filters/sjf_damper.h"
 #include "sjf_filters/sjf_dcBlock.h"
 #include "sjf_filters/sjf_oneMultAP.h"
+#include "sjf_filters/sjf_biquadBank.h"
+#include "sjf_filters/sjf_ladder.h"
+#include "sjf_filters/sjf_smootherBank.h"
 
 
 #endif /* sjf_filters_h */
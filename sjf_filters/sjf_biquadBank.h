@@ -0,0 +1,209 @@
+//
+//  sjf_biquadBank.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_biquadBank_h
+#define sjf_biquadBank_h
+
+#include <array>
+#include <cassert>
+
+namespace sjf::filters
+{
+    /**
+     A bank of independent transposed direct form II biquads, one per lane
+     All of the state and coefficients are stored lane by lane so each sample of every lane is calculated in one pass that the compiler can vectorise
+     ( e.g. 4 lanes of float fit in one SSE register, 8 in AVX, 16 in AVX512 )
+     Each lane can be a channel, a band of an EQ/crossover, a grain, etc...
+     Coefficients are in the same order as sjf_biquadCalculator::getCoefficients() --> { b0, b1, b2, a1, a2 }
+     */
+    template < typename Sample, int NLANES >
+    class biquadBank
+    {
+    public:
+        biquadBank()
+        {
+            m_b0.fill( 1 );
+            m_b1.fill( 0 );
+            m_b2.fill( 0 );
+            m_a1.fill( 0 );
+            m_a2.fill( 0 );
+            clear();
+        }
+        ~biquadBank(){}
+
+        /** Set the coefficients for a single lane, coefficients can be any container indexed 0 --> 4 ( { b0, b1, b2, a1, a2 } ) */
+        template < typename Coefficients >
+        void setCoefficients( int lane, const Coefficients& coefficients )
+        {
+            assert( lane >= 0 && lane < NLANES );
+            m_b0[ lane ] = coefficients[ 0 ];
+            m_b1[ lane ] = coefficients[ 1 ];
+            m_b2[ lane ] = coefficients[ 2 ];
+            m_a1[ lane ] = -coefficients[ 3 ];
+            m_a2[ lane ] = -coefficients[ 4 ];
+        }
+
+        /** Set the same coefficients for every lane */
+        template < typename Coefficients >
+        void setCoefficients( const Coefficients& coefficients )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+                setCoefficients( l, coefficients );
+        }
+
+        /** Process one sample for every lane in place, frame must hold NLANES samples */
+        void processFrame( Sample* frame )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+            {
+                auto x = frame[ l ];
+                auto y = x * m_b0[ l ] + m_d1[ l ];
+                m_d1[ l ] = x * m_b1[ l ] + m_d2[ l ] + y * m_a1[ l ];
+                m_d2[ l ] = x * m_b2[ l ] + y * m_a2[ l ];
+                frame[ l ] = y;
+            }
+        }
+
+        /**
+         Process a block of interleaved frames in place
+            data holds nSamples * NLANES samples, frame by frame
+         */
+        void processBlockInterleaved( Sample* data, int nSamples )
+        {
+            for ( auto n = 0; n < nSamples; ++n )
+                processFrame( data + n * NLANES );
+        }
+
+        /**
+         Process a block of separate channels in place, one per lane ( e.g. juce::AudioBuffer::getArrayOfWritePointers() )
+            any lanes above nChannels are left silent
+         */
+        void processBlock( Sample* const* channels, int nChannels, int nSamples )
+        {
+            assert( nChannels <= NLANES );
+            alignas( 64 ) std::array< Sample, NLANES > frame{};
+            for ( auto n = 0; n < nSamples; ++n )
+            {
+                for ( auto c = 0; c < nChannels; ++c )
+                    frame[ c ] = channels[ c ][ n ];
+                processFrame( frame.data() );
+                for ( auto c = 0; c < nChannels; ++c )
+                    channels[ c ][ n ] = frame[ c ];
+            }
+        }
+
+        /** Reset the state of every lane */
+        void clear()
+        {
+            m_d1.fill( 0 );
+            m_d2.fill( 0 );
+        }
+
+        /** Reset the state of a single lane */
+        void clear( int lane )
+        {
+            m_d1[ lane ] = m_d2[ lane ] = 0;
+        }
+
+        static constexpr int getNumLanes() { return NLANES; }
+
+    private:
+        static_assert( NLANES > 0, "biquadBank needs at least one lane" );
+        alignas( 64 ) std::array< Sample, NLANES > m_b0, m_b1, m_b2, m_a1, m_a2, m_d1, m_d2;
+    };
+
+    //================//================//================//================//================
+    //================//================//================//================//================
+    //================//================//================//================//================
+    /**
+     A cascade of NSTAGES biquadBanks in series, every stage is run for every lane in a single pass over each frame
+     e.g. 8 channels of a 4 stage ( 8th order ) lowpass, or the same cascade on 16 bands of a crossover
+     Stages that aren't needed can be left with their default ( pass through ) coefficients or switched off with setNumStages()
+     */
+    template < typename Sample, int NLANES, int NSTAGES >
+    class biquadCascadeBank
+    {
+    public:
+        biquadCascadeBank(){}
+        ~biquadCascadeBank(){}
+
+        /** Set the coefficients for a single stage of a single lane */
+        template < typename Coefficients >
+        void setCoefficients( int stage, int lane, const Coefficients& coefficients )
+        {
+            assert( stage >= 0 && stage < NSTAGES );
+            m_stages[ stage ].setCoefficients( lane, coefficients );
+        }
+
+        /** Set the coefficients for a single stage of every lane */
+        template < typename Coefficients >
+        void setCoefficients( int stage, const Coefficients& coefficients )
+        {
+            assert( stage >= 0 && stage < NSTAGES );
+            m_stages[ stage ].setCoefficients( coefficients );
+        }
+
+        /** Only the first nStages stages are processed */
+        void setNumStages( int nStages )
+        {
+            assert( nStages >= 0 && nStages <= NSTAGES );
+            for ( auto s = m_nStages; s < nStages; ++s )
+                m_stages[ s ].clear();
+            m_nStages = nStages;
+        }
+
+        int getNumStages() const { return m_nStages; }
+
+        /** Process one sample for every lane through every active stage in place */
+        void processFrame( Sample* frame )
+        {
+            for ( auto s = 0; s < m_nStages; ++s )
+                m_stages[ s ].processFrame( frame );
+        }
+
+        /** Process a block of interleaved frames in place, see biquadBank::processBlockInterleaved */
+        void processBlockInterleaved( Sample* data, int nSamples )
+        {
+            for ( auto n = 0; n < nSamples; ++n )
+                processFrame( data + n * NLANES );
+        }
+
+        /** Process a block of separate channels in place, see biquadBank::processBlock */
+        void processBlock( Sample* const* channels, int nChannels, int nSamples )
+        {
+            assert( nChannels <= NLANES );
+            alignas( 64 ) std::array< Sample, NLANES > frame{};
+            for ( auto n = 0; n < nSamples; ++n )
+            {
+                for ( auto c = 0; c < nChannels; ++c )
+                    frame[ c ] = channels[ c ][ n ];
+                processFrame( frame.data() );
+                for ( auto c = 0; c < nChannels; ++c )
+                    channels[ c ][ n ] = frame[ c ];
+            }
+        }
+
+        void clear()
+        {
+            for ( auto& s : m_stages )
+                s.clear();
+        }
+
+        void clear( int lane )
+        {
+            for ( auto& s : m_stages )
+                s.clear( lane );
+        }
+
+        static constexpr int getNumLanes() { return NLANES; }
+
+    private:
+        std::array< biquadBank< Sample, NLANES >, NSTAGES > m_stages;
+        int m_nStages = NSTAGES;
+    };
+}
+
+#endif /* sjf_biquadBank_h */
@@ -0,0 +1,178 @@
+//
+//  sjf_ladder.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_ladder_h
+#define sjf_ladder_h
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include "../sjf_mathsApproximations.h"
+#include "../sjf_nonlinearities.h"
+
+namespace sjf::filters
+{
+    /**
+     A bank of 4 pole zero delay feedback ( topology preserving transform ) moog style ladder lowpass filters, one per lane
+     The feedback loop is solved for each sample rather than using the previous output ( see Zavalishin, The Art of VA Filter Design ),
+     so the cutoff and resonance stay accurate right up to nyquist
+     The saturation is a fast tanh on the input to the first stage, after the feedback has been subtracted
+     All of the state and parameters are stored lane by lane, so every lane is calculated in one pass that the compiler can vectorise
+     Each lane can be a channel, a voice of a synth, etc...
+     */
+    template < typename Sample, int NLANES >
+    class ladder
+    {
+    public:
+        ladder()
+        {
+            m_G.fill( 0 );
+            m_G4.fill( 0 );
+            m_k.fill( 0 );
+            m_boost.fill( 0 );
+            m_inGain.fill( 1 );
+            m_invDen.fill( 1 );
+            for ( auto l = 0; l < NLANES; ++l )
+                setCutoff( l, 1000, 44100 );
+            clear();
+        }
+        ~ladder(){}
+
+        /** Set the cutoff frequency of a single lane, this calls a ( fast ) tan so it is best done at control rate rather than every sample */
+        void setCutoff( int lane, Sample frequency, Sample sampleRate )
+        {
+            assert( lane >= 0 && lane < NLANES );
+            frequency = std::fmin( std::fmax( frequency, Sample( 5 ) ), sampleRate * Sample( 0.45 ) );
+            auto g = sjf::maths::tanApprox( static_cast< Sample >( M_PI ) * frequency / sampleRate );
+            m_G[ lane ] = g / ( 1 + g );
+            auto G2 = m_G[ lane ] * m_G[ lane ];
+            m_G4[ lane ] = G2 * G2;
+            calculateGains( lane );
+        }
+
+        /** Set the cutoff frequency of every lane */
+        void setCutoff( Sample frequency, Sample sampleRate )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+                setCutoff( l, frequency, sampleRate );
+        }
+
+        /** Set the resonance of a single lane, 0 --> 5, above 4 the filter self oscillates with the level held by the saturation */
+        void setResonance( int lane, Sample resonance )
+        {
+            assert( lane >= 0 && lane < NLANES );
+            m_k[ lane ] = std::fmin( std::fmax( resonance, Sample( 0 ) ), Sample( 5 ) );
+            calculateGains( lane );
+        }
+
+        /** Set the resonance of every lane */
+        void setResonance( Sample resonance )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+                setResonance( l, resonance );
+        }
+
+        /** Make up for the loss of low end as the resonance increases, 0 --> 1 */
+        void setBassBoost( int lane, Sample boost )
+        {
+            assert( lane >= 0 && lane < NLANES );
+            m_boost[ lane ] = std::fmin( std::fmax( boost, Sample( 0 ) ), Sample( 1 ) );
+            calculateGains( lane );
+        }
+
+        /** Set the bass boost of every lane */
+        void setBassBoost( Sample boost )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+                setBassBoost( l, boost );
+        }
+
+        /** Process one sample for every lane in place, frame must hold NLANES samples */
+        void processFrame( Sample* frame )
+        {
+            for ( auto l = 0; l < NLANES; ++l )
+            {
+                const auto G = m_G[ l ];
+                auto x = frame[ l ] * m_inGain[ l ];
+                // each stage is y = G * x + s / ( 1 + g ), and 1 / ( 1 + g ) == 1 - G
+                auto S = ( ( ( m_s1[ l ] * G + m_s2[ l ] ) * G + m_s3[ l ] ) * G + m_s4[ l ] ) * ( 1 - G );
+                auto y = ( m_G4[ l ] * x + S ) * m_invDen[ l ];
+                auto u = nonlinearities::tanhPade::process( x - m_k[ l ] * y );
+                u = processStage( m_s1[ l ], u, G );
+                u = processStage( m_s2[ l ], u, G );
+                u = processStage( m_s3[ l ], u, G );
+                frame[ l ] = processStage( m_s4[ l ], u, G );
+            }
+        }
+
+        /**
+         Process a block of interleaved frames in place
+            data holds nSamples * NLANES samples, frame by frame
+         */
+        void processBlockInterleaved( Sample* data, int nSamples )
+        {
+            for ( auto n = 0; n < nSamples; ++n )
+                processFrame( data + n * NLANES );
+        }
+
+        /**
+         Process a block of separate channels ( or voices ) in place, one per lane
+            any lanes above nChannels are left silent
+         */
+        void processBlock( Sample* const* channels, int nChannels, int nSamples )
+        {
+            assert( nChannels <= NLANES );
+            alignas( 64 ) std::array< Sample, NLANES > frame{};
+            for ( auto n = 0; n < nSamples; ++n )
+            {
+                for ( auto c = 0; c < nChannels; ++c )
+                    frame[ c ] = channels[ c ][ n ];
+                processFrame( frame.data() );
+                for ( auto c = 0; c < nChannels; ++c )
+                    channels[ c ][ n ] = frame[ c ];
+            }
+        }
+
+        /** Reset the state of every lane */
+        void clear()
+        {
+            m_s1.fill( 0 );
+            m_s2.fill( 0 );
+            m_s3.fill( 0 );
+            m_s4.fill( 0 );
+        }
+
+        /** Reset the state of a single lane ( e.g. when a voice is stolen ) */
+        void clear( int lane )
+        {
+            m_s1[ lane ] = m_s2[ lane ] = m_s3[ lane ] = m_s4[ lane ] = 0;
+        }
+
+        static constexpr int getNumLanes() { return NLANES; }
+
+    private:
+        static_assert( NLANES > 0, "ladder needs at least one lane" );
+
+        // trapezoidal integrator one pole lowpass
+        static inline Sample processStage( Sample& s, Sample x, Sample G )
+        {
+            auto v = ( x - s ) * G;
+            auto y = v + s;
+            s = y + v;
+            return y;
+        }
+
+        void calculateGains( int lane )
+        {
+            m_invDen[ lane ] = 1 / ( 1 + m_k[ lane ] * m_G4[ lane ] );
+            m_inGain[ lane ] = 1 + m_boost[ lane ] * m_k[ lane ];
+        }
+
+        alignas( 64 ) std::array< Sample, NLANES > m_G, m_G4, m_k, m_boost, m_inGain, m_invDen, m_s1, m_s2, m_s3, m_s4;
+    };
+}
+
+#endif /* sjf_ladder_h */
@@ -0,0 +1,235 @@
+//
+//  sjf_smootherBank.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_smootherBank_h
+#define sjf_smootherBank_h
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+
+namespace sjf::filters
+{
+    enum class smootherType { linear, onepole };
+
+    /**
+     Parameter smoothing for NPARAMS parameters at once
+        linear  --> reaches the target in a fixed time ( the same as juce::SmoothedValue )
+        onepole --> exponential approach to the target ( the same as an sjf_lpf/onepole dezipper )
+     process( nSamples ) is called once per block and fills a ramp for every parameter that is still moving,
+     each ramp is a separate loop over the block so it vectorises
+     Once a parameter reaches its target the rest of its ramp is filled with the target, the part that block used is filled at the start
+     of the next block and after that it is skipped, so blocks where nothing has changed do no smoothing work at all
+     getRamp( param ) is always valid for the nSamples of the last call to process()
+        --> prepare() with the largest block size, this allocates so NOT on the audio thread
+     */
+    template < typename Sample, int NPARAMS, smootherType TYPE = smootherType::linear >
+    class smootherBank
+    {
+    public:
+        smootherBank()
+        {
+            m_current.fill( 0 );
+            m_target.fill( 0 );
+            m_step.fill( 0 );
+            m_countdown.fill( 0 );
+            m_rampLength.fill( 0 );
+            m_decay.fill( 0 );
+            m_isConstant.fill( false );
+            m_moved.fill( false );
+            m_fillPending.fill( false );
+        }
+        ~smootherBank(){}
+
+        /** Allocates, NOT for the audio thread */
+        void prepare( int maxBlockSize )
+        {
+            m_maxBlockSize = maxBlockSize;
+            for ( auto p = 0; p < NPARAMS; ++p )
+            {
+                m_ramps[ p ].assign( static_cast< size_t >( maxBlockSize ), m_current[ p ] );
+                m_isConstant[ p ] = m_countdown[ p ] == 0;
+                m_fillPending[ p ] = false;
+                if constexpr ( TYPE == smootherType::onepole )
+                {
+                    m_powers[ p ].resize( static_cast< size_t >( maxBlockSize ) );
+                    calculatePowers( p );
+                }
+            }
+        }
+
+        /**
+         Set how long a parameter takes to reach a new target
+            linear  --> the time to get all the way there
+            onepole --> the time constant ( ~63% of the way there )
+         */
+        void setSmoothingTime( int param, Sample seconds, Sample sampleRate )
+        {
+            assert( param >= 0 && param < NPARAMS );
+            const auto nSamps = std::max( seconds * sampleRate, Sample( 0 ) );
+            m_rampLength[ param ] = static_cast< int >( std::round( nSamps ) );
+            m_decay[ param ] = nSamps < 1 ? 0 : std::exp( Sample( -1 ) / nSamps );
+            if constexpr ( TYPE == smootherType::onepole )
+                calculatePowers( param );
+        }
+
+        /** Set the smoothing time of every parameter */
+        void setSmoothingTime( Sample seconds, Sample sampleRate )
+        {
+            for ( auto p = 0; p < NPARAMS; ++p )
+                setSmoothingTime( p, seconds, sampleRate );
+        }
+
+        /**
+         onepole only --> set the smoothing with the same per sample coefficient as sjf_lpf::setCutoff()
+         ( the fraction of the remaining distance to the target covered each sample )
+         */
+        void setCoefficient( int param, Sample coefficient )
+        {
+            static_assert( TYPE == smootherType::onepole, "setCoefficient is only for onepole smoothing" );
+            assert( param >= 0 && param < NPARAMS );
+            m_decay[ param ] = 1 - std::clamp( coefficient, Sample( 0 ), Sample( 0.999999 ) );
+            calculatePowers( param );
+        }
+
+        /** Set the per sample coefficient of every parameter */
+        void setCoefficient( Sample coefficient )
+        {
+            for ( auto p = 0; p < NPARAMS; ++p )
+                setCoefficient( p, coefficient );
+        }
+
+        /** Set a new value for a parameter to move towards */
+        void setTarget( int param, Sample target )
+        {
+            assert( param >= 0 && param < NPARAMS );
+            if ( target == m_target[ param ] )
+                return;
+            m_target[ param ] = target;
+            m_isConstant[ param ] = false;
+            if constexpr ( TYPE == smootherType::linear )
+            {
+                if ( m_rampLength[ param ] == 0 )
+                {
+                    m_current[ param ] = target;
+                    m_countdown[ param ] = 1; // one block to fill the ramp with the new value
+                    m_step[ param ] = 0;
+                    return;
+                }
+                m_countdown[ param ] = m_rampLength[ param ];
+                m_step[ param ] = ( target - m_current[ param ] ) / m_rampLength[ param ];
+            }
+            else
+            {
+                m_countdown[ param ] = 1;
+            }
+        }
+
+        /** Jump straight to a value with no smoothing */
+        void setCurrentAndTarget( int param, Sample value )
+        {
+            assert( param >= 0 && param < NPARAMS );
+            m_current[ param ] = m_target[ param ] = value;
+            m_step[ param ] = 0;
+            m_countdown[ param ] = 1;
+            m_isConstant[ param ] = false;
+        }
+
+        /** Fill the ramps of every parameter that is still moving for the next nSamples ( no more than the maxBlockSize given to prepare() ) */
+        void process( int nSamples )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            for ( auto p = 0; p < NPARAMS; ++p )
+            {
+                m_moved[ p ] = !m_isConstant[ p ];
+                if ( m_isConstant[ p ] )
+                {
+                    // the start of the ramp still holds the last moving values from the block where it converged
+                    if ( m_fillPending[ p ] )
+                    {
+                        std::fill( m_ramps[ p ].begin(), m_ramps[ p ].end(), m_target[ p ] );
+                        m_fillPending[ p ] = false;
+                    }
+                    continue;
+                }
+                auto* ramp = m_ramps[ p ].data();
+                const auto target = m_target[ p ];
+                auto done = false;
+                if constexpr ( TYPE == smootherType::linear )
+                {
+                    const auto len = std::min( m_countdown[ p ], nSamples );
+                    const auto start = m_current[ p ], step = m_step[ p ];
+                    for ( auto i = 0; i < len; ++i )
+                        ramp[ i ] = start + step * ( i + 1 );
+                    m_countdown[ p ] -= len;
+                    m_current[ p ] = start + step * len;
+                    done = m_countdown[ p ] == 0;
+                    if ( done )
+                        std::fill( ramp + len, ramp + m_maxBlockSize, target );
+                }
+                else
+                {
+                    const auto diff = m_current[ p ] - target;
+                    const auto* powers = m_powers[ p ].data();
+                    for ( auto i = 0; i < nSamples; ++i )
+                        ramp[ i ] = target + diff * powers[ i ];
+                    m_current[ p ] = ramp[ nSamples - 1 ];
+                    done = std::abs( m_current[ p ] - target ) <= CONVERGED * ( 1 + std::abs( target ) );
+                    if ( done )
+                        std::fill( ramp + nSamples, ramp + m_maxBlockSize, target );
+                }
+                if ( done )
+                {
+                    m_current[ p ] = target;
+                    m_countdown[ p ] = 0;
+                    m_isConstant[ p ] = true;
+                    m_fillPending[ p ] = true;
+                }
+            }
+        }
+
+        /** The smoothed values of one parameter for the last call to process() */
+        const Sample* getRamp( int param ) const { return m_ramps[ param ].data(); }
+
+        /** true if the ramp of the last block moved at all, if it is false every value of getRamp( param ) is the target */
+        bool isSmoothing( int param ) const { return m_moved[ param ]; }
+
+        /** true if any parameter will move in the next call to process() */
+        bool isAnySmoothing() const
+        {
+            for ( auto p = 0; p < NPARAMS; ++p )
+                if ( !m_isConstant[ p ] )
+                    return true;
+            return false;
+        }
+
+        Sample getCurrentValue( int param ) const { return m_current[ param ]; }
+        Sample getTarget( int param ) const { return m_target[ param ]; }
+
+        static constexpr int getNumParameters() { return NPARAMS; }
+
+    private:
+        static constexpr Sample CONVERGED = static_cast< Sample >( 1e-6 );
+
+        void calculatePowers( int param )
+        {
+            auto& powers = m_powers[ param ];
+            auto x = Sample( 1 );
+            for ( auto& p : powers )
+                p = ( x *= m_decay[ param ] );
+        }
+
+        std::array< std::vector< Sample >, NPARAMS > m_ramps, m_powers;
+        std::array< Sample, NPARAMS > m_current, m_target, m_step, m_decay;
+        std::array< int, NPARAMS > m_countdown, m_rampLength;
+        std::array< bool, NPARAMS > m_isConstant, m_moved, m_fillPending;
+        int m_maxBlockSize = 0;
+    };
+}
+
+#endif /* sjf_smootherBank_h */
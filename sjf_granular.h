@@ -61,7 +61,7 @@ public:
             {
                 phase *= 2.0f; // convert to full cycle of sine wave
                 phase -= 0.5f; // offset to lowest point in wave
-                auto output = sin( PI * phase );
+                auto output = sin( M_PI * phase );
                 output += 1; // add constatnt to bring minimum to 0
                 output *= 0.5; // halve values to normalise between 0 --> 1
                 return output;
@@ -73,7 +73,7 @@ public:
                 phase -= 0.5f;
                 phase *= 9.0f;
                 if ( phase == 0 ) { return 1; }
-                return sin( PI * phase ) / phase;
+                return sin( M_PI * phase ) / phase;
             case 3: // exponential decay
                 phase = 1 - phase;
                 return pow (phase, 2);
@@ -205,8 +205,7 @@ class sjf_grainEngine : public sjf_sampler
         //==============================================================================
         void initialiseGranSynth(int sampleRate, int samplesPerBlock)
         {
-            m_SR  = sampleRate;
-            srand((unsigned)time(NULL));
+            initialise( sampleRate );
             m_samplesPerBlock = samplesPerBlock;
             prepareReverb( m_SR, m_samplesPerBlock );
         };
@@ -238,6 +237,7 @@ class sjf_grainEngine : public sjf_sampler
         // play all of the currently active grains
         void playGrains( juce::AudioBuffer<float> &buffer )
         {
+            updateLoadedSample();
             if (!m_sampleLoadedFlag) { return; }
             for (int index = 0; index < buffer.getNumSamples(); index++)
             {
@@ -254,6 +254,7 @@ class sjf_grainEngine : public sjf_sampler
         // This is the main function used to trigger clouds from vectors
         void playCloudFromVectors( juce::AudioBuffer<float> &buffer )
         {
+            updateLoadedSample();
             buffer.clear();
             if (!m_sampleLoadedFlag || !m_canPlayFlag)
             { // if either there is no sample loaded or no cloud has been triggered, reset things and turn the synth off
@@ -265,8 +266,8 @@ class sjf_grainEngine : public sjf_sampler
                 return;
             }
             m_reverbBuffer.makeCopyOf( buffer ); // I copy the empty buffer into the reverb buffer to ensure they are the same size...
-            auto cloudLengthSamps = m_cloudLengthMS * (static_cast<float>m_SR * 0.001f);
-            auto deltaTimeSamps = m_deltaTimeMS * (static_cast<float>m_SR * 0.001f);
+            auto cloudLengthSamps = m_cloudLengthMS * (static_cast<float>(m_SR) * 0.001f);
+            auto deltaTimeSamps = m_deltaTimeMS * (static_cast<float>(m_SR) * 0.001f);
             
             for ( int index = 0; index < buffer.getNumSamples(); index ++ )
             {
@@ -434,6 +435,7 @@ class sjf_grainEngine : public sjf_sampler
         // play the cloud of grains
         void playCloud( juce::AudioBuffer<float> &buffer )
         {
+            updateLoadedSample();
             if (!m_sampleLoadedFlag || !m_canPlayFlag) { m_canPlayFlag = false;  return; }
             auto cloudLengthSamps = m_cloudLengthMS * m_SR * 0.001f;
             auto deltaTimeSamps = m_deltaTimeMS * m_SR * 0.001f;
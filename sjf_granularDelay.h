@@ -17,6 +17,8 @@
 #include "sjf_biquadWrapper.h"
 #include "sjf_lpf.h"
 #include "sjf_ringMod.h"
+#include "sjf_filters/sjf_smootherBank.h"
+#include "sjf_nonlinearities.h"
 //----------------------------------------------------------
 //----------------------------------------------------------
 //----------------------------------------------------------
@@ -68,7 +70,7 @@ private:
     std::array< std::array< T, NCHANNELS >, NCHANNELS > m_mixMatrix;
     
     static constexpr T m_windowSize = 1024;
-    static constexpr sjf_hannArray< T, static_cast< int >( m_windowSize ) > m_win;
+    static constexpr const sjf_hannArray< T, static_cast< int >( m_windowSize ) >& m_win = sjf_hannTable< T, static_cast< int >( m_windowSize ) >;
     
     std::array< T, NCHANNELS > m_samples;
     
@@ -326,15 +328,12 @@ public:
         m_sampleCount = 0;
         m_deltaTimeSamps = std::round( m_SR / m_rateHz );
         
-        m_fbSmoother.reset( m_SR, 0.1 );
-        m_fbSmoother.setCurrentAndTargetValue( 0 );
-        m_drySmoother.reset( m_SR, 0.1 );
-        m_drySmoother.setCurrentAndTargetValue( 0 );
-        m_wetSmoother.reset( m_SR, 0.1 );
-        m_wetSmoother.setCurrentAndTargetValue( 1 );
-        
-        m_outLevelSmoother.reset( m_SR, 0.1 );
-        m_outLevelSmoother.setCurrentAndTargetValue( 1 );
+        m_smoothers.setSmoothingTime( 0.1, m_SR );
+        m_smoothers.setCurrentAndTarget( smoothedParams::feedback, 0 );
+        m_smoothers.setCurrentAndTarget( smoothedParams::dry, 0 );
+        m_smoothers.setCurrentAndTarget( smoothedParams::wet, 1 );
+        m_smoothers.setCurrentAndTarget( smoothedParams::outLevel, 1 );
+        m_smoothers.prepare( SMOOTHING_BLOCK_SIZE );
         
         for ( auto & g : m_delays )
             g.initialise( m_SR );
@@ -355,12 +354,18 @@ public:
         T fbSmooth, drySmooth, wetSmooth, outSmooth, inSamp;
         auto delBufSize = m_buffers[ 0 ].size();
         int bufChan = 0;
+        const T *fbRamp = m_smoothers.getRamp( smoothedParams::feedback ), *dryRamp = m_smoothers.getRamp( smoothedParams::dry );
+        const T *wetRamp = m_smoothers.getRamp( smoothedParams::wet ), *outRamp = m_smoothers.getRamp( smoothedParams::outLevel );
         for ( int indexThroughBuffer = 0; indexThroughBuffer < blockSize; indexThroughBuffer++ )
         {
-            fbSmooth = m_fbSmoother.getNextValue();
-            drySmooth = m_drySmoother.getNextValue();
-            wetSmooth = m_wetSmoother.getNextValue();
-            outSmooth = m_outLevelSmoother.getNextValue();
+            // smoothed parameters are calculated for a chunk of samples at a time
+            auto indexThroughChunk = indexThroughBuffer % SMOOTHING_BLOCK_SIZE;
+            if ( indexThroughChunk == 0 )
+                m_smoothers.process( std::min( SMOOTHING_BLOCK_SIZE, blockSize - indexThroughBuffer ) );
+            fbSmooth = fbRamp[ indexThroughChunk ];
+            drySmooth = dryRamp[ indexThroughChunk ];
+            wetSmooth = wetRamp[ indexThroughChunk ];
+            outSmooth = outRamp[ indexThroughChunk ];
             m_writePos = fastMod( m_writePos, delBufSize );
             for ( auto & s : outSamples )
                 s = 0;
@@ -389,7 +394,7 @@ public:
                 bufChan = fastMod4< int >( c, numOutChannels );
                 inSamp = buffer.getSample( bufChan, indexThroughBuffer );
                 m_buffers[ c ][ m_writePos ] += inSamp;
-                m_buffers[ c ][ m_writePos ] += m_shouldControlFB ? ( juce::dsp::FastMathApproximations::tanh( outSamples[ c ] ) * fbSmooth ) : ( outSamples[ c ] * fbSmooth );
+                m_buffers[ c ][ m_writePos ] += m_shouldControlFB ? ( sjf::nonlinearities::tanhPade::process( outSamples[ c ] ) * fbSmooth ) : ( outSamples[ c ] * fbSmooth );
                 outSamples[ c ] = calculateOutputSample( outSamples[ c ], inSamp, wetSmooth, drySmooth, dryInsertEnv, outSmooth );
                 buffer.setSample( bufChan, indexThroughBuffer, outSamples[ c ] );
                 // apply dcBlock before next sample
@@ -417,7 +422,7 @@ public:
 #ifndef NDEBUG
         assert ( fbPercentage >= 0 && fbPercentage <= 100 );
 #endif
-        m_fbSmoother.setTargetValue( fbPercentage * 0.01f );
+        m_smoothers.setTarget( smoothedParams::feedback, fbPercentage * 0.01f );
     }
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -533,8 +538,8 @@ public:
         auto dry = 1.0f - wet;
         dry = dry > 0.0f ? std::sqrt( dry ) : 0;
         
-        m_drySmoother.setTargetValue( dry );
-        m_wetSmoother.setTargetValue( wet );
+        m_smoothers.setTarget( smoothedParams::dry, dry );
+        m_smoothers.setTarget( smoothedParams::wet, wet );
     }
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -621,7 +626,7 @@ public:
     void setOutputLevel( T outLevelDB )
     {
         auto gain = std::pow( 10.0, outLevelDB / 20.0 );
-        m_outLevelSmoother.setTargetValue( gain );
+        m_smoothers.setTarget( smoothedParams::outLevel, gain );
     }
 private:
     //-----------------------------------------------------------------------------------
@@ -677,7 +682,7 @@ private:
     private:
         static constexpr int NWINDOWS =  2;
         static constexpr T m_windowSize = 1024;
-        static constexpr sjf_hannArray< T, static_cast< int >( m_windowSize ) > m_win;
+        static constexpr const sjf_hannArray< T, static_cast< int >( m_windowSize ) >& m_win = sjf_hannTable< T, static_cast< int >( m_windowSize ) >;
         
         bool m_lastTriggeredGrain = false;
         std::array< T, NWINDOWS > m_count{ 0, 0 };
@@ -902,7 +907,9 @@ private:
     int m_interpType = sjf_interpolators::interpolatorTypes::pureData;
     int m_insertStateCount = 0;
     
-    juce::SmoothedValue< T > m_fbSmoother, m_drySmoother, m_wetSmoother, m_outLevelSmoother;
+    enum smoothedParams { feedback, dry, wet, outLevel, NSMOOTHEDPARAMS };
+    static constexpr int SMOOTHING_BLOCK_SIZE = 64;
+    sjf::filters::smootherBank< T, NSMOOTHEDPARAMS > m_smoothers;
     
     insertDryGrainEnv m_dryGainInsertEnv;
     
@@ -953,4 +953,48 @@ float cubicInterpolate(juce::AudioBuffer<float> &buffer, const int channel, cons
     
     return (a0*mu*mu2 + a1*mu2 + a2*mu + a3);
 }
+//==============================================================================
+//==============================================================================
+//==============================================================================
+//                      SPAN BASED INTERPOLATIONS
+//==============================================================================
+//==============================================================================
+//==============================================================================
+//==============================================================================
+// interpolates a whole run of read positions from a single channel in one go
+// the interpolation is chosen at compile time using the same numbering as the samplers' m_interpolationType
+//      1 linear, 2 cubic, 3 pureData, 4 fourth order, 5 godot, 6 hermite
+// read positions are wrapped to the length of the buffer
+template < int INTERPOLATION_TYPE >
+inline void interpolateSpan( const float* samples, const int bufferSize, const float* readPos, float* destination, const int nSamples )
+{
+    const auto fBufferSize = static_cast< float >( bufferSize );
+    for ( int s = 0; s < nSamples; s++ )
+    {
+        auto findex = fastMod4< float >( readPos[ s ], fBufferSize );
+        auto index = static_cast< int >( findex );
+        auto mu = findex - index;
+        auto y1 = samples[ index ];
+        auto y2 = samples[ fastMod4< int >( index + 1, bufferSize ) ];
+        if constexpr ( INTERPOLATION_TYPE <= 1 )
+        {
+            destination[ s ] = linearInterpolate( mu, y1, y2 );
+        }
+        else
+        {
+            auto y0 = samples[ index == 0 ? bufferSize - 1 : index - 1 ];
+            auto y3 = samples[ fastMod4< int >( index + 2, bufferSize ) ];
+            if constexpr ( INTERPOLATION_TYPE == 2 )
+                destination[ s ] = cubicInterpolate( mu, y0, y1, y2, y3 );
+            else if constexpr ( INTERPOLATION_TYPE == 3 )
+                destination[ s ] = fourPointInterpolatePD( mu, y0, y1, y2, y3 );
+            else if constexpr ( INTERPOLATION_TYPE == 4 )
+                destination[ s ] = fourPointFourthOrderOptimal( mu, y0, y1, y2, y3 );
+            else if constexpr ( INTERPOLATION_TYPE == 5 )
+                destination[ s ] = cubicInterpolateGodot( mu, y0, y1, y2, y3 );
+            else
+                destination[ s ] = cubicInterpolateHermite( mu, y0, y1, y2, y3 );
+        }
+    }
+}
 #endif /* sjf_interpolationTypes_h */
@@ -23,6 +23,12 @@ public:
     ~sjf_lfo(){};
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     float output()
+    {
+        return output( 1 );
+    }
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /** output for the current position and then move on by nSamples ( e.g. when only evaluated at control rate ), sjf_randOSC::output( nSamples ) works the same way */
+    float output( int nSamples )
     {
         if ( m_isSyncedToTempo )
         {
@@ -39,13 +45,13 @@ public:
         m_lastPhase = m_phase;
         if ( m_isSyncedToTempo ) // work directly with position if synced to tempo
         {
-            m_pos += m_increment; // increase position per sample
+            m_pos += m_increment * nSamples; // increase position per sample
             if ( m_pos >= 1.0 )
             {
                 m_pos -= static_cast<int>( m_pos ); // make sure position is always betweeo 0 --> 1
             }
         }
-        m_count++; // if Hz based count is just simply increased by one sample
+        m_count += nSamples; // if Hz based count is just simply increased by one sample
         while ( m_count >= m_SR )
         {
             m_count -= m_SR;
@@ -53,7 +59,11 @@ public:
         
         if ( m_lfoType == noise1 )
         { // smooth out random changes slightly
-            return lpf.filterInput ( m_out ) + m_offset;
+            auto out = lpf.filterInput ( m_out );
+            // the filter is moved on by the same nSamples so its smoothing time doesn't depend on how often this is called
+            for ( auto i = 1; i < nSamples; i++ )
+                lpf.filterInput ( m_out );
+            return out + m_offset;
         }
         return m_out + m_offset;
     }
@@ -9,6 +9,12 @@
 #ifndef sjf_mathsApproximations_h
 #define sjf_mathsApproximations_h
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <limits>
+
 namespace sjf::maths
 {
     template< typename Sample >
@@ -21,6 +27,113 @@ namespace sjf::maths
         auto den = 5 * M_PI * M_PI - 4*x * pix;
         return neg ? -num/den : num/den;
     }
+    
+    /**
+     cos( 2 * pi * phase ) for a phase between 0 --> 1
+     folds the phase into the first quarter and uses a taylor series there, accurate to about 5e-7 with no branches ( so it vectorises )
+     */
+    template< typename Sample >
+    inline Sample cosPhaseApprox( Sample phase )
+    {
+        auto a = std::abs( phase - Sample( 0.5 ) ); // cos( 2 pi phase ) == -cos( 2 pi a )
+        auto flip = a > Sample( 0.25 );
+        a = flip ? Sample( 0.5 ) - a : a;
+        auto x = a * Sample( 2.0 * M_PI );
+        auto z = x * x;
+        auto c = Sample( 1 ) + z*( Sample( -1.0/2.0 ) + z*( Sample( 1.0/24.0 ) + z*( Sample( -1.0/720.0 ) + z*( Sample( 1.0/40320.0 ) + z*Sample( -1.0/3628800.0 ) ) ) ) );
+        return flip ? c : -c;
+    }
+
+    /**
+     tan( x ) for x between 0 --> ~1.4 ( i.e. the bilinear prewarp tan( pi * f / sampleRate ) up to 0.45 * sampleRate )
+     7/6 pade approximant, relative error below 4e-9 over that range, one division and no branches
+     */
+    template< typename Sample >
+    inline Sample tanApprox( Sample x )
+    {
+        auto z = x * x;
+        auto num = x * ( Sample( 135135 ) + z*( Sample( -17325 ) + z*( Sample( 378 ) - z ) ) );
+        auto den = Sample( 135135 ) + z*( Sample( -62370 ) + z*( Sample( 3150 ) - Sample( 28 )*z ) );
+        return num / den;
+    }
+
+    /**
+     e^x with about 2e-7 relative error ( for doubles as well, so only use it where that is enough )
+     2^( x * log2( e ) ) is split into a whole number, which is written straight into the exponent bits, and a fraction, which uses a polynomial
+     there are no branches or library calls so it vectorises
+     */
+    template< typename Sample >
+    inline Sample expApprox( Sample x )
+    {
+        static_assert( std::is_floating_point_v< Sample >, "expApprox needs a floating point type" );
+        constexpr bool isFloat = sizeof( Sample ) == 4;
+        using Bits = std::conditional_t< isFloat, uint32_t, uint64_t >;
+        constexpr int MANTISSA_BITS = isFloat ? 23 : 52, BIAS = isFloat ? 127 : 1023;
+        constexpr Sample LIMIT = isFloat ? 87 : 708;
+        constexpr Sample SHIFTER = isFloat ? 12582912.0 : 6755399441055744.0; // 1.5 * 2^MANTISSA_BITS, adding it rounds to a whole number held in the lowest bits
+        x = std::abs( x ) > LIMIT ? std::copysign( LIMIT, x ) : x; // written this way as a min/max clamp gets turned back into branches by gcc
+        auto t = x * Sample( M_LOG2E );
+        auto shifted = t + SHIFTER;
+        Bits wholeBits, shifterBits;
+        std::memcpy( &wholeBits, &shifted, sizeof( Sample ) );
+        std::memcpy( &shifterBits, &SHIFTER, sizeof( Sample ) );
+        // the whole number is read back from the bits rather than as shifted - SHIFTER, which -ffast-math would fold away
+        auto whole = static_cast< Sample >( static_cast< std::make_signed_t< Bits > >( wholeBits - shifterBits ) );
+        auto z = ( t - whole ) * Sample( M_LN2 ); // -0.35 --> 0.35
+        auto p = Sample( 1 ) + z*( Sample( 1 ) + z*( Sample( 1.0/2.0 ) + z*( Sample( 1.0/6.0 ) + z*( Sample( 1.0/24.0 ) + z*( Sample( 1.0/120.0 ) + z*Sample( 1.0/720.0 ) ) ) ) ) );
+        Bits scaleBits = ( wholeBits + BIAS ) << MANTISSA_BITS;
+        Sample scale;
+        std::memcpy( &scale, &scaleBits, sizeof( Sample ) );
+        return p * scale;
+    }
+
+    /**
+     atan2( y, x ) with about 3e-7 radians error
+     the smaller of |x| and |y| over the larger gives a ratio of 0 --> 1 for a polynomial, which is then folded out to the right quadrant
+     there are no branches so it vectorises
+     */
+    template< typename Sample >
+    inline Sample atan2Approx( Sample y, Sample x )
+    {
+        const auto ax = std::abs( x ), ay = std::abs( y );
+        const auto swap = ay > ax;
+        const auto num = swap ? ax : ay, den = swap ? ay : ax;
+        const auto a = num / ( den + std::numeric_limits< Sample >::min() ); // atan2( 0, 0 ) == 0
+        const auto z = a * a;
+        auto r = a * ( Sample( 0.9999961115 ) + z*( Sample( -0.3331736799 ) + z*( Sample( 0.1980781477 ) + z*( Sample( -0.1323333857 ) + z*( Sample( 0.0796236024 ) + z*( Sample( -0.03360415654 ) + z*Sample( 0.00681177129 ) ) ) ) ) ) );
+        r = swap ? Sample( M_PI_2 ) - r : r;
+        r = x < 0 ? Sample( M_PI ) - r : r;
+        return std::copysign( r, y );
+    }
+
+    /**
+     natural log for x > 0 with about 1e-7 relative error
+     the exponent is read straight from the bits and the mantissa ( folded to sqrt( 0.5 ) --> sqrt( 2 ) ) goes through a series in ( m - 1 )/( m + 1 )
+     there are no branches or library calls so it vectorises
+     */
+    template< typename Sample >
+    inline Sample logApprox( Sample x )
+    {
+        static_assert( std::is_floating_point_v< Sample >, "logApprox needs a floating point type" );
+        constexpr bool isFloat = sizeof( Sample ) == 4;
+        using Bits = std::conditional_t< isFloat, uint32_t, uint64_t >;
+        using SignedBits = std::make_signed_t< Bits >;
+        constexpr int MANTISSA_BITS = isFloat ? 23 : 52, BIAS = isFloat ? 127 : 1023;
+        constexpr Bits MANTISSA_MASK = ( Bits( 1 ) << MANTISSA_BITS ) - 1;
+        Bits bits;
+        std::memcpy( &bits, &x, sizeof( Sample ) );
+        auto exponent = static_cast< Sample >( static_cast< SignedBits >( bits >> MANTISSA_BITS ) - BIAS );
+        Bits mantissaBits = ( bits & MANTISSA_MASK ) | ( Bits( BIAS ) << MANTISSA_BITS );
+        Sample m;
+        std::memcpy( &m, &mantissaBits, sizeof( Sample ) ); // 1 --> 2
+        const auto fold = m > Sample( M_SQRT2 );
+        m = fold ? m * Sample( 0.5 ) : m;
+        exponent = fold ? exponent + 1 : exponent;
+        const auto s = ( m - 1 ) / ( m + 1 ); // -0.172 --> 0.172
+        const auto z = s * s;
+        const auto series = 2 * s * ( Sample( 1 ) + z*( Sample( 1.0/3.0 ) + z*( Sample( 1.0/5.0 ) + z*( Sample( 1.0/7.0 ) + z*Sample( 1.0/9.0 ) ) ) ) );
+        return exponent * Sample( M_LN2 ) + series;
+    }
 }
 
 #endif /* sjf_mathsApproximations_h */
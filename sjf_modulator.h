@@ -12,6 +12,8 @@
 #include "sjf_audioUtilitiesC++.h"
 #include "sjf_filters.h"
 #include "sjf_mathsApproximations.h"
+#include <algorithm>
+#include <cassert>
 
 namespace sjf::modulator
 {
@@ -103,7 +105,116 @@ namespace sjf::modulator
         T m_offset{0.0};
         sinMod<T> m_mod;
     };
-    
+
+//=============//=============//=============//=============//=============
+//=============//=============//=============//=============//=============
+//=============//=============//=============//=============//=============
+//=============//=============//=============//=============//=============
+    /**
+     Evaluates NSOURCES modulation sources at control rate and fills a per sample linear ramp for each of them
+     Most modulation is well below 20Hz so there is no audible difference, but the sources ( lfos, random oscillators, modVoices, etc... )
+     are only calculated once every controlInterval samples rather than every sample
+        --> prepare() with the largest block size, this allocates so NOT on the audio thread
+        --> process( nSamples, evaluate ) once per block, evaluate( targets, nSamples ) is called every controlInterval samples
+            it should write the next value of every source into targets and move each source on by nSamples
+        --> getRamp( source ) then holds nSamples values that can be read by as many destinations as needed
+     The ramps arrive at each new value at the end of the interval, so the modulation is delayed by one controlInterval
+     */
+    template < typename T, int NSOURCES >
+    class controlRateEngine
+    {
+    public:
+        controlRateEngine(){}
+        ~controlRateEngine(){}
+
+        /** Allocates, NOT for the audio thread */
+        void prepare( int maxBlockSize )
+        {
+            m_maxBlockSize = maxBlockSize;
+            for ( auto& r : m_ramps )
+                r.assign( static_cast< size_t >( maxBlockSize ), 0 );
+        }
+
+        /** number of samples between each evaluation of the sources ( e.g. 8, 16, 32 ), takes effect at the next evaluation */
+        void setControlInterval( int interval )
+        {
+            assert( interval > 0 );
+            m_interval = interval;
+        }
+
+        int getControlInterval() const { return m_interval; }
+
+        /**
+         Jump every ramp straight to a set of values ( e.g. the first values of the sources ) without interpolation
+         the sources are evaluated again at the start of the next block
+         */
+        void reset( const std::array< T, NSOURCES >& values )
+        {
+            m_current = values;
+            m_increment.fill( 0 );
+            m_target = values;
+            m_countdown = 0;
+        }
+
+        /**
+         Fill the ramps for the next nSamples ( no more than the maxBlockSize given to prepare() )
+            evaluate is called as evaluate( std::array< T, NSOURCES >& targets, int nSamples )
+         */
+        template < typename Evaluate >
+        void process( int nSamples, Evaluate&& evaluate )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            auto pos = 0;
+            while ( pos < nSamples )
+            {
+                if ( m_countdown == 0 )
+                {
+                    m_current = m_target;
+                    evaluate( m_target, m_interval );
+                    const auto invInterval = T( 1 ) / m_interval;
+                    for ( auto s = 0; s < NSOURCES; ++s )
+                        m_increment[ s ] = ( m_target[ s ] - m_current[ s ] ) * invInterval;
+                    m_countdown = m_interval;
+                    ++m_nEvaluations;
+                }
+                const auto len = std::min( m_countdown, nSamples - pos );
+                for ( auto s = 0; s < NSOURCES; ++s )
+                {
+                    auto* ramp = m_ramps[ s ].data() + pos;
+                    const auto start = m_current[ s ], inc = m_increment[ s ];
+                    for ( auto i = 0; i < len; ++i )
+                        ramp[ i ] = start + inc * i;
+                    m_current[ s ] = start + inc * len;
+                }
+                m_countdown -= len;
+                pos += len;
+            }
+            m_nSamples += nSamples;
+        }
+
+        /** The ramp for one source from the last call to process() */
+        const T* getRamp( int source ) const { return m_ramps[ source ].data(); }
+
+        /** The value of one source at one sample of the last block */
+        T getValue( int source, int sample ) const { return m_ramps[ source ][ sample ]; }
+
+        /** Number of times each source has been evaluated since the counts were last reset */
+        size_t getNumEvaluations() const { return m_nEvaluations; }
+
+        /** Number of evaluations per source that were not needed compared to evaluating every sample */
+        size_t getNumEvaluationsSaved() const { return m_nSamples > m_nEvaluations ? m_nSamples - m_nEvaluations : 0; }
+
+        /** Proportion of the per sample evaluations that were saved, 0 --> 1 ( e.g. 0.97 with a control interval of 32 ) */
+        double getProportionSaved() const { return m_nSamples == 0 ? 0.0 : static_cast< double >( getNumEvaluationsSaved() ) / m_nSamples; }
+
+        void resetCounts() { m_nEvaluations = m_nSamples = 0; }
+
+    private:
+        std::array< std::vector< T >, NSOURCES > m_ramps;
+        std::array< T, NSOURCES > m_current{}, m_target{}, m_increment{};
+        int m_interval = 16, m_countdown = 0, m_maxBlockSize = 0;
+        size_t m_nEvaluations = 0, m_nSamples = 0;
+    };
 
 //    /** class for modulation of  values --> outputs maximum of 0 --> 2* nominal val */
 //    template < typename T, typename MODFUNCTOR = randMod< T > >
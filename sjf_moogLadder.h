@@ -4,6 +4,7 @@
 //  Created by Simon Fay on 13/11/2022.
 //
 //  modifieed implementation of Will Pirkle's Moog Ladder Emulation
+//  see sjf::filters::ladder ( sjf_filters/sjf_ladder.h ) for a zero delay feedback version that can run several voices/channels at once
 
 
 
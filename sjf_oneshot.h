@@ -108,8 +108,7 @@ public:
     //==============================================================================
     void initialise(int sampleRate)
     {
-        m_SR  = sampleRate;
-        srand((unsigned)time(NULL));
+        sjf_sampler::initialise( sampleRate );
         for(int i = 0; i < m_nVoices; i++)
         {
             oneshotVoices[i]->initialise(m_SR);
@@ -126,6 +125,7 @@ public:
     //==============================================================================
     void playOneShot( juce::AudioBuffer<float> &destinationBuffer )
     {
+        updateLoadedSample();
         if ( !m_sampleLoadedFlag ){ return; }
         for(int i = 0; i < m_nVoices; i++)
         {
@@ -161,6 +161,12 @@ public:
         return m_pan;
     }
     //==============================================================================
+    // the loaded sample, or nullptr if nothing has been loaded
+    const juce::AudioBuffer<float>* getSampleBuffer() const
+    {
+        return m_sampleLoadedFlag ? &m_AudioSample : nullptr;
+    }
+    //==============================================================================
 private:
     const static int m_nVoices = 2;
     juce::OwnedArray < sjf_oneshotVoice > oneshotVoices;
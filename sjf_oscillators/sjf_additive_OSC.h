@@ -102,7 +102,88 @@ namespace sjf::oscillators
             }
             return output;
         }
+        
+        /**
+         Render a block of samples
+            phase is the phase ( 0 --> 1 ) at the start of the block, increment is the change in phase per sample
+         Each partial is generated by a complex rotator ( a couple of multiply adds per partial per sample ) instead of a sin approximation.
+         The rotators are reseeded from the phase at the start of every block and renormalised periodically within it so they never drift.
+         Partials that would be at or above nyquist, or have no amplitude, are skipped
+         */
+        void processBlock( Sample* output, size_t nSamples, Sample phase, Sample increment )
+        {
+            auto nPartials = seedRotators( phase, increment );
+            if ( nPartials == 0 )
+            {
+                std::fill( output, output + nSamples, Sample( 0 ) );
+                return;
+            }
+            for ( size_t n = 0; n < nSamples; ++n )
+            {
+                // partials are spread across LANES accumulators so the inner loop vectorises without reordering a reduction
+                std::array< Sample, LANES > acc{};
+                for ( size_t k = 0; k < nPartials; k += LANES )
+                {
+                    for ( size_t j = 0; j < LANES; ++j )
+                    {
+                        auto re = m_re[ k + j ], im = m_im[ k + j ];
+                        acc[ j ] += im;
+                        m_re[ k + j ] = re * m_rotRe[ k + j ] - im * m_rotIm[ k + j ];
+                        m_im[ k + j ] = re * m_rotIm[ k + j ] + im * m_rotRe[ k + j ];
+                    }
+                }
+                Sample sum = 0;
+                for ( auto a : acc )
+                    sum += a;
+                output[ n ] = sum;
+                if ( ( n & ( RENORMALISE_INTERVAL - 1 ) ) == RENORMALISE_INTERVAL - 1 )
+                    renormalise( nPartials );
+            }
+        }
     private:
+        // sets up the rotators for the active partials, returns the number of partials to process ( padded to a multiple of LANES )
+        size_t seedRotators( Sample phase, Sample increment )
+        {
+            size_t n = 0;
+            const auto absInc = std::abs( increment );
+            for ( auto i = 0; i < m_nSinWaves; ++i )
+            {
+                if ( m_amps[ i ] == 0 || absInc * m_freqMults[ i ] >= 0.5 )
+                    continue;
+                // seeding is done in double as the rotators carry any error for the rest of the block
+                double p = static_cast< double >( phase ) * m_freqMults[ i ];
+                p = ( p - std::floor( p ) ) * 2.0 * M_PI;
+                auto w = static_cast< double >( increment ) * m_freqMults[ i ] * 2.0 * M_PI;
+                m_re[ n ] = static_cast< Sample >( m_amps[ i ] * std::cos( p ) );
+                m_im[ n ] = static_cast< Sample >( m_amps[ i ] * std::sin( p ) );
+                m_rotRe[ n ] = static_cast< Sample >( std::cos( w ) );
+                m_rotIm[ n ] = static_cast< Sample >( std::sin( w ) );
+                m_invAmpSq[ n ] = 1 / ( m_amps[ i ] * m_amps[ i ] );
+                ++n;
+            }
+            if ( n == 0 )
+                return 0;
+            // silent padding partials
+            for ( ; n % LANES != 0; ++n )
+            {
+                m_re[ n ] = m_im[ n ] = m_rotIm[ n ] = m_invAmpSq[ n ] = 0;
+                m_rotRe[ n ] = 1;
+            }
+            return n;
+        }
+        
+        // pulls each rotator back onto its circle ( first order correction, the error is tiny by the time this is called )
+        void renormalise( size_t nPartials )
+        {
+            for ( size_t i = 0; i < nPartials; ++i )
+            {
+                auto g = Sample( 1.5 ) - Sample( 0.5 ) * ( m_re[ i ]*m_re[ i ] + m_im[ i ]*m_im[ i ] ) * m_invAmpSq[ i ];
+                m_re[ i ] *= g;
+                m_im[ i ] *= g;
+            }
+        }
+        
+
         template< int SIZE, typename FUNCTOR >
         struct waveTable
         {
@@ -192,6 +273,11 @@ namespace sjf::oscillators
         //==========//==========//==========//==========//==========//==========//==========//==========
         int m_nSinWaves{ MAXNHARMS };
         std::array< Sample, MAXNHARMS > m_freqMults, m_amps;
+        
+        static constexpr size_t LANES = 8, RENORMALISE_INTERVAL = 64;
+        static constexpr size_t PADDEDNHARMS = ( ( MAXNHARMS + LANES - 1 ) / LANES ) * LANES;
+        // rotator state for processBlock, structure of arrays so each simd lane advances one partial
+        alignas( 32 ) std::array< Sample, PADDEDNHARMS > m_re, m_im, m_rotRe, m_rotIm, m_invAmpSq;
         static constexpr waveTable< MAXNHARMS, sawFreqMult > m_sawFreqs;
         static constexpr waveTable< MAXNHARMS, sqrFreqMult > m_sqrFreqs;
         static constexpr waveTable< MAXNHARMS, triFreqMult > m_triFreqs;
@@ -9,6 +9,8 @@
 #ifndef sjf_phasor_h
 #define sjf_phasor_h
 
+#include <cmath>
+
 
 namespace sjf::oscillators
 {
@@ -48,6 +50,30 @@ namespace sjf::oscillators
             m_phase = (m_phase >= 1) ? m_phase - 1.0f : ( (m_phase < 0.0f) ? m_phase + 1.0f : m_phase);
             return p;
         }
+        
+        /**
+         Output a block of samples from the phasor
+         Each phase is calculated from the phase at the start of the block rather than accumulated, so the loop has no dependencies and vectorises
+         */
+        void processBlock( Sample* output, size_t nSamples )
+        {
+            const auto start = m_phase, inc = m_increment;
+            for ( size_t n = 0; n < nSamples; ++n )
+            {
+                auto p = start + inc * static_cast< Sample >( n );
+                p -= std::floor( p );
+                output[ n ] = p < 1 ? p : 0; // tiny negative phases can round up to 1
+            }
+            auto p = start + inc * static_cast< Sample >( nSamples );
+            p -= std::floor( p );
+            m_phase = p < 1 ? p : 0;
+        }
+        
+        /** the current phase ( i.e. the next value that will be output ) */
+        Sample getPhase() const { return m_phase; }
+        
+        /** the current increment per sample */
+        Sample getIncrement() const { return m_increment; }
     };
 
     
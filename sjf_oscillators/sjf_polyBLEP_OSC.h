@@ -10,6 +10,8 @@
 #define sjf_polyBLEP_OSC_h
 #include "sjf_phasor.h"
 #include "sjf_oscTypes.h"
+#include "../sjf_mathsApproximations.h"
+#include <cassert>
 namespace sjf::oscillators
 {
 
@@ -47,6 +49,12 @@ namespace sjf::oscillators
             // otherwise just output 0
             return 0;
         }
+        
+        /** returns true if the phase is close enough to a discontinuity to need correcting */
+        bool isNearDiscontinuity( Sample phase ) const
+        {
+            return phase < m_increment || phase > ( 1 - m_increment );
+        }
     private:
         Sample m_increment;
     };
@@ -115,6 +123,69 @@ namespace sjf::oscillators
             }
         }
         
+        /**
+         process a block of phases ( e.g. from phasor::processBlock ) using the type set with setType()
+         output must not be the same buffer as phase
+         */
+        void processBlock( const Sample* phase, Sample* output, size_t nSamples )
+        {
+            switch ( m_type ) {
+                case oscType::sin:
+                    return processBlock< oscType::sin >( phase, output, nSamples );
+                case oscType::saw:
+                    return processBlock< oscType::saw >( phase, output, nSamples );
+                case oscType::square:
+                    return processBlock< oscType::square >( phase, output, nSamples );
+                case oscType::triangle:
+                    return processBlock< oscType::triangle >( phase, output, nSamples );
+                default:
+                    break;
+            }
+        }
+        
+        /**
+         process a block of phases for a particular oscillator type
+         the naive waveform is calculated for the whole block first ( this vectorises ),
+         then polyBLEP corrections are added only to the few samples next to a discontinuity
+         output must not be the same buffer as phase
+         */
+        template < oscType type >
+        void processBlock( const Sample* phase, Sample* output, size_t nSamples )
+        {
+            assert( phase != output );
+            if constexpr ( type == oscType::sin )
+            {
+                for ( size_t n = 0; n < nSamples; ++n )
+                    output[ n ] = sjf::maths::cosPhaseApprox( phase[ n ] );
+            }
+            else if constexpr ( type == oscType::saw )
+            {
+                for ( size_t n = 0; n < nSamples; ++n )
+                    output[ n ] = phase[ n ] * 2 - 1;
+                for ( size_t n = 0; n < nSamples; ++n )
+                    if ( m_pb.isNearDiscontinuity( phase[ n ] ) )
+                        output[ n ] -= m_pb.process( phase[ n ] );
+            }
+            else if constexpr ( type == oscType::square || type == oscType::triangle )
+            {
+                for ( size_t n = 0; n < nSamples; ++n )
+                    output[ n ] = phase[ n ] < 0.5 ? 1 : -1;
+                for ( size_t n = 0; n < nSamples; ++n )
+                {
+                    auto p = phase[ n ];
+                    auto half = p + Sample( 0.5 );
+                    half = half < 1 ? half : half - 1;
+                    if ( m_pb.isNearDiscontinuity( p ) || m_pb.isNearDiscontinuity( half ) )
+                        output[ n ] += m_pb.process( p ) - m_pb.process( half );
+                }
+                if constexpr ( type == oscType::triangle )
+                {
+                    for ( size_t n = 0; n < nSamples; ++n )
+                        output[ n ] = m_integrator.process( output[ n ] );
+                }
+            }
+        }
+        
         /** process the next value of the sin oscillator */
         Sample processSin( Sample phase )
         {
@@ -0,0 +1,222 @@
+//
+//  sjf_wavetable_OSC.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_wavetable_OSC_h
+#define sjf_wavetable_OSC_h
+
+#include "../sjf_table.h"
+#include "../sjf_fft.h"
+#include <algorithm>
+#include <array>
+#include <complex>
+#include <vector>
+#include <cmath>
+
+namespace sjf::oscillators
+{
+    /**
+     Band limited ( mip mapped ) wavetable oscillator for arbitrary waveforms
+     When a table is set, octave spaced copies are built with fewer and fewer harmonics ( level 0 has them all, each level above has half as many ).
+     During playback the level is chosen so that no harmonic is above nyquist, processBlock() crossfades between levels when it changes.
+     Setting a table allocates so should NOT be done on the audio thread
+     */
+    template < typename Sample, long TABLE_SIZE, interpolation::interpolatorTypes interpType = interpolation::interpolatorTypes::linear >
+    class wavetableOsc
+    {
+    public:
+        wavetableOsc()
+        {
+            setTable( []( Sample phase ){ return std::sin( phase * 2.0 * M_PI ); } );
+        }
+        ~wavetableOsc(){}
+
+        /** build the tables from a functor returning the waveform for a phase between 0 --> 1 */
+        template < typename Functor >
+        void setTable( Functor waveform )
+        {
+            std::vector< std::complex< double > > spectrum( TABLE_SIZE );
+            for ( auto i = 0; i < TABLE_SIZE; ++i )
+                spectrum[ i ] = static_cast< double >( waveform( static_cast< Sample >( i ) / SIZE ) );
+            buildLevels( spectrum );
+        }
+
+        /** build the tables from an existing table ( e.g. a sjf::wavetable::tab ) */
+        template < typename Functor, interpolation::interpolatorTypes tabInterpType >
+        void setTable( const wavetable::tab< Sample, TABLE_SIZE, Functor, tabInterpType >& table )
+        {
+            setTable( [ &table ]( Sample phase ){ return table.getVal( phase ); } );
+        }
+
+        /** build the tables from a single cycle of a waveform of any length */
+        void setTable( const Sample* waveform, size_t length )
+        {
+            assert( length > 0 );
+            setTable( [ waveform, length ]( Sample phase )
+            {
+                auto findex = phase * length;
+                auto index = static_cast< size_t >( findex );
+                auto mu = findex - index;
+                return waveform[ index ] + mu * ( waveform[ ( index + 1 ) % length ] - waveform[ index ] );
+            } );
+        }
+
+        /**
+         set the frequency used by process()
+         processBlock() picks its level from the increment it is given, call this before the first block so it doesn't fade in from the full bandwidth table
+         */
+        void setFrequency( const Sample f, const Sample sampleRate ) { setIncrement( f / sampleRate ); }
+
+        /** set the phase increment per sample used by process() */
+        void setIncrement( const Sample inc ) { m_level = calculateLevel( inc ); }
+
+        /** output the value at a particular phase ( 0 --> 1 ) using the level set by setFrequency()/setIncrement() */
+        Sample process( Sample phase ) const
+        {
+            return m_interpolator( getLevel( m_level ), WRAPMASK, phase * SIZE );
+        }
+
+        /**
+         Render a block of samples
+            phase is the phase ( 0 --> 1 ) at the start of the block, increment is the change in phase per sample
+         If the increment needs a different level to the last block the two are crossfaded over this block
+         The block is worked through in chunks of CHUNKSIZE: read positions, then the table reads, then the interpolation, each as a separate loop so they vectorise
+         */
+        void processBlock( Sample* output, size_t nSamples, Sample phase, Sample increment )
+        {
+            auto level = calculateLevel( increment );
+            const auto* table = getLevel( level );
+            const auto* previous = getLevel( m_level );
+            const auto fade = level != m_level;
+            const auto fadeStep = nSamples > 0 ? Sample( 1 ) / nSamples : Sample( 0 );
+            const auto start = ( phase - std::floor( phase ) ) * SIZE, step = increment * SIZE;
+            for ( size_t chunk = 0; chunk < nSamples; chunk += CHUNKSIZE )
+            {
+                const auto n = std::min( CHUNKSIZE, nSamples - chunk );
+                auto* out = output + chunk;
+                calculatePositions( start + step * chunk, step, n );
+                readTable( table, out, n );
+                if ( !fade )
+                    continue;
+                readTable( previous, m_faded.data(), n );
+                const auto fadeStart = fadeStep * static_cast< Sample >( chunk + 1 );
+                for ( size_t i = 0; i < n; ++i )
+                    out[ i ] = m_faded[ i ] + ( out[ i ] - m_faded[ i ] ) * ( fadeStart + fadeStep * static_cast< int >( i ) );
+            }
+            m_level = level;
+        }
+
+        /** number of band limited copies of the table */
+        static constexpr int getNumLevels() { return NLEVELS; }
+
+    private:
+        // level l keeps the harmonics up to (TABLE_SIZE/2) >> l,
+        // so the lowest level with no harmonics above nyquist is ceil( log2( TABLE_SIZE * increment ) )
+        int calculateLevel( Sample increment ) const
+        {
+            auto x = std::abs( increment ) * SIZE;
+            if ( x <= 1 )
+                return 0;
+            auto level = static_cast< int >( std::ceil( std::log2( x ) ) );
+            return level < NLEVELS ? level : NLEVELS - 1;
+        }
+
+        // each level is stored with one guard point before and two after so the block reads don't need to wrap
+        const Sample* getLevel( int level ) const { return m_tables.data() + static_cast< size_t >( level ) * STRIDE + 1; }
+
+        // integer read position ( already wrapped ) and fractional part for n samples starting at position first ( in samples )
+        void calculatePositions( Sample first, Sample step, size_t n )
+        {
+            first -= std::floor( first / SIZE ) * SIZE;
+            // a negative increment is offset by whole tables so every position is positive and truncation rounds down
+            if ( step < 0 )
+                first += std::ceil( -step * n / SIZE ) * SIZE;
+            for ( size_t i = 0; i < n; ++i )
+            {
+                auto position = first + step * static_cast< int >( i ); // int rather than size_t, the conversion vectorises
+                auto index = static_cast< int >( position );
+                m_mu[ i ] = position - index;
+                m_index[ i ] = index & static_cast< int >( WRAPMASK );
+            }
+        }
+
+        // gather the points around each read position from calculatePositions(), then interpolate
+        void readTable( const Sample* table, Sample* output, size_t n )
+        {
+            using types = interpolation::interpolatorTypes;
+            if constexpr ( interpType == types::none )
+            {
+                for ( size_t i = 0; i < n; ++i )
+                    output[ i ] = table[ m_index[ i ] ];
+                return;
+            }
+            for ( size_t i = 0; i < n; ++i )
+            {
+                m_x1[ i ] = table[ m_index[ i ] ];
+                m_x2[ i ] = table[ m_index[ i ] + 1 ];
+            }
+            if constexpr ( interpType != types::linear ) // only the four point interpolators need the outer points
+            {
+                for ( size_t i = 0; i < n; ++i )
+                {
+                    m_x0[ i ] = table[ m_index[ i ] - 1 ];
+                    m_x3[ i ] = table[ m_index[ i ] + 2 ];
+                }
+            }
+            for ( size_t i = 0; i < n; ++i )
+                output[ i ] = m_interpolator( m_mu[ i ], m_x0[ i ], m_x1[ i ], m_x2[ i ], m_x3[ i ] );
+        }
+
+        void buildLevels( std::vector< std::complex< double > >& spectrum )
+        {
+            spectral::fft< double > fft;
+            fft.prepare( TABLE_SIZE );
+            fft.perform( spectrum, false );
+            m_tables.resize( static_cast< size_t >( NLEVELS ) * STRIDE );
+            std::vector< std::complex< double > > band( TABLE_SIZE );
+            for ( auto l = 0; l < NLEVELS; ++l )
+            {
+                const auto maxHarmonic = ( TABLE_SIZE / 2 ) >> l;
+                std::fill( band.begin(), band.end(), std::complex< double >( 0 ) );
+                band[ 0 ] = spectrum[ 0 ];
+                for ( auto k = 1; k <= maxHarmonic; ++k )
+                {
+                    band[ k ] = spectrum[ k ];
+                    band[ TABLE_SIZE - k ] = spectrum[ TABLE_SIZE - k ];
+                }
+                fft.perform( band, true );
+                auto* table = m_tables.data() + static_cast< size_t >( l ) * STRIDE + 1;
+                for ( auto i = 0; i < TABLE_SIZE; ++i )
+                    table[ i ] = static_cast< Sample >( band[ i ].real() / TABLE_SIZE );
+                table[ -1 ] = table[ TABLE_SIZE - 1 ];
+                table[ TABLE_SIZE ] = table[ 0 ];
+                table[ TABLE_SIZE + 1 ] = table[ 1 ];
+            }
+        }
+
+        static constexpr int calculateNumLevels()
+        {
+            int n = 0;
+            for ( auto h = TABLE_SIZE / 2; h >= 1; h >>= 1 )
+                ++n;
+            return n;
+        }
+
+        static_assert( TABLE_SIZE >= 4 && ( TABLE_SIZE & ( TABLE_SIZE - 1 ) ) == 0, "TABLE_SIZE must be a power of 2" );
+        static constexpr Sample SIZE{ TABLE_SIZE };
+        static constexpr long WRAPMASK{ TABLE_SIZE - 1 };
+        static constexpr int NLEVELS = calculateNumLevels();
+        static constexpr size_t STRIDE = TABLE_SIZE + 3, CHUNKSIZE = 64;
+
+        std::vector< Sample > m_tables;
+        int m_level{ 0 };
+        // scratch for processBlock(), structure of arrays so each loop vectorises
+        alignas( 32 ) std::array< Sample, CHUNKSIZE > m_mu{}, m_x0{}, m_x1{}, m_x2{}, m_x3{}, m_faded{};
+        alignas( 32 ) std::array< int, CHUNKSIZE > m_index{};
+        interpolation::interpolator< Sample, interpType > m_interpolator;
+    };
+}
+
+#endif /* sjf_wavetable_OSC_h */
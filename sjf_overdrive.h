@@ -7,6 +7,7 @@
 #ifndef sjf_overdrive_h
 #define sjf_overdrive_h
 #include <JuceHeader.h>
+#include "sjf_nonlinearities.h"
 template< typename T >
 struct sjf_drive
 {
@@ -19,6 +20,15 @@ struct sjf_drive
     {
         input = juce::dsp::FastMathApproximations::tanh( input * drive  ) / juce::dsp::FastMathApproximations::tanh( drive );
     }
+    
+    /** the same as driveInput for a whole block, in and out can be the same buffer */
+    static inline void driveBlock( const T* in, T* out, size_t nSamples, const T& drive )
+    {
+        using shaper = sjf::nonlinearities::tanhPade;
+        const auto makeUp = 1 / shaper::process( drive );
+        for ( size_t i = 0; i < nSamples; ++i )
+            out[ i ] = shaper::process( in[ i ] * drive ) * makeUp;
+    }
 };
 
 
@@ -29,12 +39,10 @@ public:
     ~sjf_overdrive(){};
     void drive(juce::AudioBuffer<float>& buffer, float gain)
     {
-        for (int index = 0; index < buffer.getNumSamples(); index++)
+        for (int channel = 0; channel < buffer.getNumChannels(); channel++)
         {
-            for (int channel = 0; channel < buffer.getNumChannels(); channel++)
-            {
-                buffer.setSample(channel, index, tanh( buffer.getSample(channel, index) * gain ) );
-            }
+            auto* samples = buffer.getWritePointer( channel );
+            sjf::nonlinearities::tanhExp::processBlock( samples, samples, static_cast< size_t >( buffer.getNumSamples() ), gain );
         }
     }
     
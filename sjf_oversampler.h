@@ -0,0 +1,282 @@
+//
+//  sjf_oversampler.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Real time 2x / 4x / 8x oversampling for nonlinear processes.
+//  Each octave is a polyphase half band IIR filter made from two parallel chains of first order allpasses,
+//  coefficients are designed with the elliptic method used by Laurent de Soras' hiir library
+//
+
+#ifndef sjf_oversampler_h
+#define sjf_oversampler_h
+
+#include <cmath>
+#include <vector>
+#include <array>
+#include <cassert>
+
+namespace sjf::oversampling
+{
+    /**
+     Coefficients for a polyphase half band filter
+        nCoefs          --> number of allpass sections ( split between the two chains )
+        transitionBW    --> width of the transition band relative to the sample rate, 0 --> 0.5 ( narrower needs more coefficients for the same rejection )
+     */
+    inline std::vector< double > designHalfBand( int nCoefs, double transitionBW )
+    {
+        auto k = std::tan( ( 1 - transitionBW * 2 ) * M_PI / 4 );
+        k *= k;
+        const auto kkSqrt = std::pow( 1 - k * k, 0.25 );
+        const auto e = 0.5 * ( 1 - kkSqrt ) / ( 1 + kkSqrt );
+        const auto e4 = e * e * e * e;
+        const auto q = e * ( 1 + e4 * ( 2 + e4 * ( 15 + 150 * e4 ) ) );
+        const auto order = nCoefs * 2 + 1;
+
+        std::vector< double > coefs( nCoefs );
+        for ( auto index = 0; index < nCoefs; ++index )
+        {
+            const auto c = index + 1;
+            double num = 0, den = 0, term = 0, sign = 1;
+            auto i = 0;
+            do
+            {
+                term = std::pow( q, i * ( i + 1 ) ) * std::sin( ( i * 2 + 1 ) * c * M_PI / order ) * sign;
+                num += term;
+                sign = -sign;
+                ++i;
+            } while ( std::abs( term ) > 1e-100 );
+            i = 1;
+            sign = -1;
+            do
+            {
+                term = std::pow( q, i * i ) * std::cos( i * 2 * c * M_PI / order ) * sign;
+                den += term;
+                sign = -sign;
+                ++i;
+            } while ( std::abs( term ) > 1e-100 );
+            const auto ww = num * std::pow( q, 0.25 ) / ( den + 0.5 );
+            const auto wwSq = ww * ww;
+            const auto x = std::sqrt( ( 1 - wwSq * k ) * ( 1 - wwSq / k ) ) / ( 1 + wwSq );
+            coefs[ index ] = ( 1 - x ) / ( 1 + x );
+        }
+        return coefs;
+    }
+
+    //================//================//================//================//================
+    /**
+     One octave of up and down sampling
+     H( z ) = 0.5 * ( A( z^2 ) + z^-1 * B( z^2 ) ), the even coefficients make up A and the odd ones B,
+     so each chain only ever runs at the lower rate
+     The number of coefficients is fixed at compile time so the chains unroll and their state stays in registers,
+     this lets consecutive samples overlap in the pipeline rather than waiting on each section in turn
+     */
+    template < typename Sample, int NCOEFS >
+    class halfBandStage
+    {
+    public:
+        halfBandStage(){}
+        ~halfBandStage(){}
+
+        /** coefs must hold NCOEFS values ( e.g. from designHalfBand() ) */
+        void setCoefficients( const std::vector< double >& coefs )
+        {
+            assert( coefs.size() == NCOEFS );
+            for ( auto i = 0; i < NCOEFS; ++i )
+                ( i % 2 == 0 ? m_coefA[ i / 2 ] : m_coefB[ i / 2 ] ) = static_cast< Sample >( coefs[ i ] );
+            reset();
+
+            // group delay at dc ( in samples at the higher rate ) of a first order allpass ( a + z^-1 )/( 1 + a z^-1 ) is ( 1 - a )/( 1 + a ) at the lower rate
+            double delayA = 0, delayB = 0;
+            for ( auto a : m_coefA )
+                delayA += 2.0 * ( 1.0 - a ) / ( 1.0 + a );
+            for ( auto b : m_coefB )
+                delayB += 2.0 * ( 1.0 - b ) / ( 1.0 + b );
+            m_groupDelay = ( delayA + 1.0 + delayB ) * 0.5;
+        }
+
+        /** output must hold nSamples * 2 samples */
+        void upsample( const Sample* input, Sample* output, int nSamples )
+        {
+            auto up = m_up; // local copy so the compiler can keep it in registers
+            for ( auto n = 0; n < nSamples; ++n )
+            {
+                output[ 2 * n ] = processChain( m_coefA, up.xA, up.yA, input[ n ] );
+                output[ 2 * n + 1 ] = processChain( m_coefB, up.xB, up.yB, input[ n ] );
+            }
+            m_up = up;
+        }
+
+        /** input holds nSamples * 2 samples, output and input can be the same buffer */
+        void downsample( const Sample* input, Sample* output, int nSamples )
+        {
+            auto down = m_down;
+            auto lastOdd = m_lastOdd;
+            for ( auto n = 0; n < nSamples; ++n )
+            {
+                auto even = input[ 2 * n ], odd = input[ 2 * n + 1 ];
+                auto a = processChain( m_coefA, down.xA, down.yA, even );
+                auto b = processChain( m_coefB, down.xB, down.yB, lastOdd );
+                lastOdd = odd;
+                output[ n ] = ( a + b ) * Sample( 0.5 );
+            }
+            m_down = down;
+            m_lastOdd = lastOdd;
+        }
+
+        /** group delay at low frequencies of one pass through the filter, in samples at the higher rate */
+        double getGroupDelay() const { return m_groupDelay; }
+
+        void reset()
+        {
+            m_up.reset();
+            m_down.reset();
+            m_lastOdd = 0;
+        }
+
+    private:
+        static constexpr int NA = ( NCOEFS + 1 ) / 2, NB = NCOEFS / 2;
+
+        struct chainState
+        {
+            std::array< Sample, NA > xA{}, yA{};
+            std::array< Sample, NB > xB{}, yB{};
+            void reset()
+            {
+                xA.fill( 0 );
+                yA.fill( 0 );
+                xB.fill( 0 );
+                yB.fill( 0 );
+            }
+        };
+
+        // y[ n ] = a * ( x[ n ] - y[ n - 1 ] ) + x[ n - 1 ]
+        template < size_t N >
+        static inline Sample processChain( const std::array< Sample, N >& coefs, std::array< Sample, N >& x1, std::array< Sample, N >& y1, Sample x )
+        {
+            for ( size_t i = 0; i < N; ++i )
+            {
+                auto y = coefs[ i ] * ( x - y1[ i ] ) + x1[ i ];
+                x1[ i ] = x;
+                y1[ i ] = y;
+                x = y;
+            }
+            return x;
+        }
+
+        std::array< Sample, NA > m_coefA{};
+        std::array< Sample, NB > m_coefB{};
+        chainState m_up, m_down;
+        Sample m_lastOdd = 0;
+        double m_groupDelay = 0;
+    };
+
+    //================//================//================//================//================
+    /**
+     Oversamples a mono signal by 2, 4 or 8 so that a nonlinear process can be run at the higher rate
+        --> prepare() with the factor and the largest block size, this allocates so NOT on the audio thread
+        --> process( data, nSamples, functor ) upsamples the block, calls the functor for every oversampled sample and downsamples back in place
+     or call upsample(), work on the returned buffer yourself and then downsample()
+     The filters are IIR so the latency is not a whole number of samples and not quite the same at every frequency,
+     getLatencyInSamples() reports the delay at low frequencies
+     The first octave does nearly all of the anti aliasing so it gets the most coefficients, later octaves only need to reject images well above the original band
+     */
+    template < typename Sample >
+    class oversampler
+    {
+    public:
+        oversampler(){}
+        ~oversampler(){}
+
+        /**
+         factor must be 2, 4 or 8
+         Allocates, NOT for the audio thread
+         */
+        void prepare( int factor, int maxBlockSize )
+        {
+            assert( factor == 2 || factor == 4 || factor == 8 );
+            m_factor = factor;
+            m_nStages = factor == 2 ? 1 : factor == 4 ? 2 : 3;
+            m_maxBlockSize = maxBlockSize;
+            m_firstStage.setCoefficients( designHalfBand( FIRST_STAGE_COEFS, FIRST_STAGE_TRANSITION ) );
+            for ( auto& s : m_laterStages )
+                s.setCoefficients( designHalfBand( LATER_STAGE_COEFS, LATER_STAGE_TRANSITION ) );
+            // an up and a down pass through each stage, converted back to samples at the base rate
+            m_latency = m_firstStage.getGroupDelay();
+            for ( auto s = 1; s < m_nStages; ++s )
+                m_latency += 2.0 * m_laterStages[ s - 1 ].getGroupDelay() / ( 1 << ( s + 1 ) );
+            for ( auto& b : m_buffers )
+                b.assign( static_cast< size_t >( maxBlockSize ) * factor, 0 );
+            reset();
+        }
+
+        /**
+         Upsample a block of nSamples ( no more than the maxBlockSize given to prepare() )
+         returns the oversampled block of nSamples * getFactor() samples, it can be modified in place before calling downsample()
+         */
+        Sample* upsample( const Sample* input, int nSamples )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            const Sample* in = input;
+            for ( auto s = 0; s < m_nStages; ++s )
+            {
+                auto* out = m_buffers[ s % 2 ].data();
+                if ( s == 0 )
+                    m_firstStage.upsample( in, out, nSamples );
+                else
+                    m_laterStages[ s - 1 ].upsample( in, out, nSamples << s );
+                in = out;
+            }
+            return m_buffers[ ( m_nStages - 1 ) % 2 ].data();
+        }
+
+        /** Downsample the block returned by the last call to upsample() back to nSamples at the base rate */
+        void downsample( Sample* output, int nSamples )
+        {
+            for ( auto s = m_nStages - 1; s >= 0; --s )
+            {
+                const auto* in = m_buffers[ s % 2 ].data();
+                auto* out = s == 0 ? output : m_buffers[ ( s - 1 ) % 2 ].data();
+                if ( s == 0 )
+                    m_firstStage.downsample( in, out, nSamples );
+                else
+                    m_laterStages[ s - 1 ].downsample( in, out, nSamples << s );
+            }
+        }
+
+        /** Run a per sample functor ( Sample( Sample ) ) at the oversampled rate on a block in place */
+        template < typename Functor >
+        void process( Sample* data, int nSamples, Functor&& function )
+        {
+            auto* os = upsample( data, nSamples );
+            const auto nOversampled = nSamples * m_factor;
+            for ( auto n = 0; n < nOversampled; ++n )
+                os[ n ] = function( os[ n ] );
+            downsample( data, nSamples );
+        }
+
+        void reset()
+        {
+            m_firstStage.reset();
+            for ( auto& s : m_laterStages )
+                s.reset();
+        }
+
+        int getFactor() const { return m_factor; }
+
+        /** delay at low frequencies introduced by up and down sampling, in samples at the base rate */
+        double getLatencyInSamples() const { return m_latency; }
+
+    private:
+        static constexpr int FIRST_STAGE_COEFS = 12, LATER_STAGE_COEFS = 4;
+        static constexpr double FIRST_STAGE_TRANSITION = 0.04, LATER_STAGE_TRANSITION = 0.25;
+
+        halfBandStage< Sample, FIRST_STAGE_COEFS > m_firstStage;
+        std::array< halfBandStage< Sample, LATER_STAGE_COEFS >, 2 > m_laterStages;
+        std::array< std::vector< Sample >, 2 > m_buffers;
+        int m_factor = 2, m_nStages = 1, m_maxBlockSize = 0;
+        double m_latency = 0;
+    };
+}
+
+#endif /* sjf_oversampler_h */
@@ -0,0 +1,559 @@
+//
+//  sjf_phaseVocoder.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_phaseVocoder_h
+#define sjf_phaseVocoder_h
+
+#include <vector>
+#include <array>
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+#include "sjf_fft.h"
+#include "sjf_mathsApproximations.h"
+
+namespace sjf::spectral
+{
+    /**
+     Phase vocoder pitch shifting and time stretching, an alternative to the delay line pitch shifters ( sjf::delayLine::pitchShift etc... )
+     that does not comb filter at large intervals
+
+     Each hop the spectrum is split into regions around its peaks. Only the peaks have their phase advanced from their measured frequency,
+     every other bin keeps its phase relative to its peak ( identity phase locking, Laroche & Dolson ) which keeps the sound of each partial together
+     Pitch is changed by moving each region to the bin nearest its peak frequency * the pitch scaling, so the input and output rates stay the same
+     Formant preservation moves a smoothed ( log magnitude ) spectral envelope back to where it was before the shift
+
+     Two channels go through each complex fft at once ( as real and imaginary parts ) and the magnitude / phase / sin / cos work is done in plain loops over the bins
+     with the branch free approximations from sjf_mathsApproximations.h, so it vectorises
+     Larger ffts give better frequency resolution ( and lower notes ) at the cost of latency and smeared transients, more overlap costs more cpu but is smoother
+        --> prepare() with the number of channels, the largest block size, the fft size and overlap, this allocates so NOT on the audio thread
+        --> live input --> process( input, output, nSamples ), pitch only, delayed by getLatencyInSamples()
+        --> pulled input ( e.g. a sampler reading from a buffer ) --> processStretched(), pitch and time, with getInputRequired() samples of input each call
+     Use one or the other between calls to reset()
+     */
+    template < typename Sample >
+    class phaseVocoder
+    {
+    public:
+        phaseVocoder(){}
+        ~phaseVocoder(){}
+
+        /**
+         fftSize must be a power of 2, overlap must be a power of 2 of at least 4 ( the hop is fftSize / overlap )
+         Allocates, NOT for the audio thread
+         */
+        void prepare( int nChannels, int maxBlockSize, int fftSize = 2048, int overlap = 4 )
+        {
+            assert( fftSize >= 16 && ( fftSize & ( fftSize - 1 ) ) == 0 );
+            assert( overlap >= 4 && ( overlap & ( overlap - 1 ) ) == 0 && overlap < fftSize );
+            m_nChannels = nChannels;
+            m_maxBlockSize = maxBlockSize;
+            m_fftSize = fftSize;
+            m_overlap = overlap;
+            m_hop = fftSize / overlap;
+            m_nBins = fftSize / 2 + 1;
+            m_fft.prepare( fftSize );
+            m_fftBuffer.assign( fftSize, 0 );
+
+            // periodic hann for analysis and synthesis, hann^2 at an overlap of 4 or more adds up to 3 * overlap / 8
+            // the inverse fft is not scaled so that is folded in as well
+            m_window.resize( fftSize );
+            for ( auto i = 0; i < fftSize; ++i )
+                m_window[ i ] = static_cast< Sample >( 0.5 - 0.5 * std::cos( 2.0 * M_PI * i / fftSize ) );
+            m_outputScale = static_cast< Sample >( 1.0 / ( fftSize * 3.0 * overlap / 8.0 ) );
+
+            // a fractional shift ( see processSpectrum() ) also fades the partial towards the edges of the frame by | ( 1 - f ) + f e^( i theta ) |,
+            // this is the average loss weighted by the windows, which is made up when the region is shifted
+            for ( size_t i = 0; i < m_fractionGain.size(); ++i )
+            {
+                const auto f = static_cast< double >( i ) / ( m_fractionGain.size() - 1 );
+                double sum = 0, weight = 0;
+                for ( auto n = 0; n < fftSize; ++n )
+                {
+                    const auto w2 = static_cast< double >( m_window[ n ] ) * m_window[ n ];
+                    const auto theta = 2.0 * M_PI * ( n - fftSize / 2 ) / fftSize;
+                    sum += w2 * std::sqrt( 1.0 - 2.0 * f * ( 1.0 - f ) * ( 1.0 - std::cos( theta ) ) );
+                    weight += w2;
+                }
+                m_fractionGain[ i ] = static_cast< Sample >( weight / sum );
+            }
+
+            // the most input a single call can add is a hop per output hop ( plus the hops that are skipped at the start ) at the fastest speed
+            const auto maxHops = ( maxBlockSize + m_hop - 1 ) / m_hop + overlap;
+            const auto maxAnalysisHop = static_cast< int >( std::ceil( m_hop / MIN_STRETCH ) );
+            m_inputCapacity = fftSize + std::max( maxBlockSize, ( maxHops + 1 ) * maxAnalysisHop );
+
+            m_channels.resize( nChannels );
+            for ( auto& ch : m_channels )
+                ch.prepare( m_nBins, fftSize, m_inputCapacity, maxBlockSize + 2 * m_hop );
+            m_peaks.resize( m_nBins );
+            m_envelopeSum.resize( m_nBins + 1 );
+            m_maxEnvelopeWidth = std::max( fftSize / ENVELOPE_WIDTH_DIVISOR, 1 );
+
+            setPitchScaling( m_pitch );
+            setStretchFactor( m_stretch );
+            reset();
+        }
+
+        /** Clear everything that is buffered ( e.g. when a new note starts ) */
+        void reset()
+        {
+            for ( auto& ch : m_channels )
+                ch.reset();
+            // the frames that would start before the input are only partly filled, start with fftSize - hop of silence so the first frame ends a hop into the input
+            m_inputEnd = m_fftSize - m_hop;
+            m_analysisPos = 0;
+            m_prevPos = -m_hop;
+            m_outputCount = 0;
+            m_hopsToSkip = m_overlap - 1;
+            m_isFirstCall = true;
+        }
+
+        /** Set the pitch scaling factor ( e.g. 2 would be an octave above, 0.5 an octave below ), limited to 0.25 --> 4 */
+        void setPitchScaling( Sample scaleFactor )
+        {
+            m_pitch = std::clamp( scaleFactor, static_cast< Sample >( MIN_PITCH ), static_cast< Sample >( MAX_PITCH ) );
+        }
+
+        /**
+         Output length / input length for processStretched(), e.g. 2 --> half speed, 0.5 --> double speed
+         Limited to 0.25 --> 4
+         Do not change it between getInputRequired() and processStretched()
+         */
+        void setStretchFactor( Sample stretchFactor )
+        {
+            m_stretch = std::clamp( stretchFactor, static_cast< Sample >( MIN_STRETCH ), static_cast< Sample >( MAX_STRETCH ) );
+            m_analysisHop = static_cast< double >( m_hop ) / m_stretch;
+        }
+
+        /** Keep the spectral envelope ( formants ) where it is when the pitch is shifted */
+        void setFormantPreservation( bool shouldPreserveFormants ) { m_preserveFormants = shouldPreserveFormants; }
+
+        Sample getPitchScaling() const { return m_pitch; }
+        Sample getStretchFactor() const { return m_stretch; }
+        bool getFormantPreservation() const { return m_preserveFormants; }
+
+        /**
+         Pitch shift live input, nSamples in and nSamples out ( no more than the maxBlockSize given to prepare() )
+         The output is delayed by getLatencyInSamples(), the stretch factor is ignored
+         */
+        void process( const Sample* const* input, Sample* const* output, int nSamples )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            if ( m_isFirstCall )
+            {
+                // every frame is heard and a hop of silence covers the wait for the first one
+                m_hopsToSkip = 0;
+                for ( auto& ch : m_channels )
+                    std::fill( ch.output.begin(), ch.output.begin() + m_hop, 0 );
+                m_outputCount = m_hop;
+                m_isFirstCall = false;
+            }
+            discardUsedInput();
+            appendInput( input, nSamples );
+            while ( m_inputEnd >= static_cast< int >( std::lround( m_analysisPos ) ) + m_fftSize )
+                processHop( m_hop );
+            readOutput( output, nSamples );
+        }
+
+        /** The number of new input samples that processStretched() needs to produce the next nSamples of output */
+        int getInputRequired( int nSamples ) const
+        {
+            auto hops = nSamples > m_outputCount ? ( nSamples - m_outputCount + m_hop - 1 ) / m_hop : 0;
+            if ( hops == 0 )
+                return 0;
+            hops += m_hopsToSkip;
+            // positions are stepped exactly as processHop() steps them, so the rounding is the same
+            auto pos = m_analysisPos;
+            for ( auto h = 1; h < hops; ++h )
+                pos += m_analysisHop;
+            return std::max( static_cast< int >( std::lround( pos ) ) + m_fftSize - m_inputEnd, 0 );
+        }
+
+        /**
+         Pitch shift and time stretch pulled input, produce nSamples of output ( no more than the maxBlockSize given to prepare() )
+            input must hold getInputRequired( nSamples ) samples for each channel
+         The first output sample lines up with the first input sample, there is no latency
+         */
+        void processStretched( const Sample* const* input, Sample* const* output, int nSamples )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            m_isFirstCall = false;
+            const auto nIn = getInputRequired( nSamples );
+            discardUsedInput();
+            appendInput( input, nIn );
+            while ( m_outputCount < nSamples )
+                processHop( m_analysisHop );
+            readOutput( output, nSamples );
+        }
+
+        /** Delay of process(), in samples */
+        int getLatencyInSamples() const { return m_fftSize; }
+
+        int getFFTSize() const { return m_fftSize; }
+        int getHopSize() const { return m_hop; }
+
+    private:
+        static constexpr double MIN_PITCH = 0.25, MAX_PITCH = 4, MIN_STRETCH = 0.25, MAX_STRETCH = 4;
+        // the envelope is held and averaged over +/- this * the spacing of the loud peaks, no more than +/- fftSize / ENVELOPE_WIDTH_DIVISOR bins ( +/- sampleRate / 128 Hz )
+        static constexpr Sample ENVELOPE_WIDTH_PER_SPACING = static_cast< Sample >( 0.5 );
+        static constexpr int ENVELOPE_WIDTH_DIVISOR = 128;
+        // peaks within -40dB of the loudest bin set the envelope width
+        static constexpr Sample LOUD_PEAK = static_cast< Sample >( 0.01 );
+        // largest change the formant correction can make, in nepers ( ~ +/- 26dB )
+        static constexpr Sample MAX_FORMANT_CORRECTION = 3;
+        // lowest level of the envelope relative to the loudest bin ( -60dB )
+        static constexpr Sample ENVELOPE_FLOOR = static_cast< Sample >( 1e-3 );
+        // quieter bins than this are never peaks
+        static constexpr Sample PEAK_THRESHOLD = static_cast< Sample >( 1e-9 );
+
+        struct channelState
+        {
+            // analysis --> magnitude, phase ( in cycles ), phase of the last frame
+            // synthesis --> phase ( in cycles, per analysis bin ), real / imaginary parts before and after the shift
+            std::vector< Sample > re, im, magnitude, phase, prevPhase, advance, logMagnitude, envelope, synthPhase, shiftedRe, shiftedIm, outRe, outIm, gain;
+            std::vector< Sample > input, overlap, output;
+
+            void prepare( int nBins, int fftSize, int inputCapacity, int outputCapacity )
+            {
+                for ( auto* v : { &re, &im, &magnitude, &phase, &prevPhase, &advance, &logMagnitude, &envelope, &synthPhase, &shiftedRe, &shiftedIm, &outRe, &outIm, &gain } )
+                    v->assign( nBins, 0 );
+                input.assign( inputCapacity, 0 );
+                overlap.assign( fftSize, 0 );
+                output.assign( outputCapacity, 0 );
+            }
+
+            void reset()
+            {
+                for ( auto* v : { &prevPhase, &synthPhase, &input, &overlap } )
+                    std::fill( v->begin(), v->end(), 0 );
+            }
+        };
+
+        void appendInput( const Sample* const* input, int nIn )
+        {
+            assert( m_inputEnd + nIn <= m_inputCapacity );
+            for ( auto c = 0; c < m_nChannels; ++c )
+                std::copy( input[ c ], input[ c ] + nIn, m_channels[ c ].input.begin() + m_inputEnd );
+            m_inputEnd += nIn;
+        }
+
+        void readOutput( Sample* const* output, int nSamples )
+        {
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                auto* out = m_channels[ c ].output.data();
+                std::copy( out, out + nSamples, output[ c ] );
+                std::copy( out + nSamples, out + m_outputCount, out );
+            }
+            m_outputCount -= nSamples;
+        }
+
+        // move the input that is still needed to the start of the buffer
+        void discardUsedInput()
+        {
+            const auto shift = std::min( static_cast< int >( std::lround( m_analysisPos ) ), m_inputEnd );
+            if ( shift <= 0 )
+                return;
+            for ( auto& ch : m_channels )
+                std::copy( ch.input.begin() + shift, ch.input.begin() + m_inputEnd, ch.input.begin() );
+            m_inputEnd -= shift;
+            m_prevPos -= shift;
+            m_analysisPos -= shift;
+        }
+
+        // analyse, shift and resynthesise one frame of every channel, then move a hop of output to the output buffers
+        void processHop( double analysisHop )
+        {
+            const auto pos = static_cast< int >( std::lround( m_analysisPos ) );
+            assert( pos + m_fftSize <= m_inputEnd );
+            const auto hop = pos - m_prevPos; // the actual hop between frames, after rounding
+            const auto N = m_fftSize;
+            const auto* window = m_window.data();
+            auto* z = m_fftBuffer.data();
+            for ( auto c = 0; c < m_nChannels; c += 2 )
+            {
+                const auto isPair = c + 1 < m_nChannels;
+                auto& chA = m_channels[ c ];
+                auto& chB = m_channels[ isPair ? c + 1 : c ];
+                const auto* a = chA.input.data() + pos;
+                const auto* b = chB.input.data() + pos;
+                const Sample bGain = isPair ? 1 : 0;
+                for ( auto i = 0; i < N; ++i )
+                    z[ i ] = std::complex< Sample >( a[ i ] * window[ i ], b[ i ] * window[ i ] * bGain );
+                m_fft.perform( z, false );
+
+                // A[ k ] = ( Z[ k ] + conj( Z[ -k ] ) ) / 2, B[ k ] = ( Z[ k ] - conj( Z[ -k ] ) ) / 2i
+                for ( auto k = 0; k < m_nBins; ++k )
+                {
+                    const auto zk = z[ k ], zm = z[ ( N - k ) & ( N - 1 ) ];
+                    chA.re[ k ] = ( zk.real() + zm.real() ) * Sample( 0.5 );
+                    chA.im[ k ] = ( zk.imag() - zm.imag() ) * Sample( 0.5 );
+                }
+                if ( isPair )
+                {
+                    for ( auto k = 0; k < m_nBins; ++k )
+                    {
+                        const auto zk = z[ k ], zm = z[ ( N - k ) & ( N - 1 ) ];
+                        chB.re[ k ] = ( zk.imag() + zm.imag() ) * Sample( 0.5 );
+                        chB.im[ k ] = ( zm.real() - zk.real() ) * Sample( 0.5 );
+                    }
+                }
+                processSpectrum( chA, hop );
+                if ( isPair )
+                    processSpectrum( chB, hop );
+
+                // both outputs are real so Z = A + iB, with the upper half of each spectrum the conjugate of the lower half
+                for ( auto k = 0; k < m_nBins; ++k )
+                    z[ k ] = std::complex< Sample >( chA.outRe[ k ] - chB.outIm[ k ] * bGain, chA.outIm[ k ] + chB.outRe[ k ] * bGain );
+                for ( auto k = m_nBins; k < N; ++k )
+                {
+                    const auto m = N - k;
+                    z[ k ] = std::complex< Sample >( chA.outRe[ m ] + chB.outIm[ m ] * bGain, -chA.outIm[ m ] + chB.outRe[ m ] * bGain );
+                }
+                m_fft.perform( z, true );
+
+                auto* olaA = chA.overlap.data();
+                auto* olaB = chB.overlap.data();
+                const auto scale = m_outputScale;
+                for ( auto i = 0; i < N; ++i )
+                    olaA[ i ] += z[ i ].real() * window[ i ] * scale;
+                if ( isPair )
+                    for ( auto i = 0; i < N; ++i )
+                        olaB[ i ] += z[ i ].imag() * window[ i ] * scale;
+            }
+
+            // the hops that are skipped at the start only cover the silence before the input
+            const auto isHeard = m_hopsToSkip == 0;
+            for ( auto& ch : m_channels )
+            {
+                auto& ola = ch.overlap;
+                if ( isHeard )
+                    std::copy( ola.begin(), ola.begin() + m_hop, ch.output.begin() + m_outputCount );
+                std::copy( ola.begin() + m_hop, ola.end(), ola.begin() );
+                std::fill( ola.end() - m_hop, ola.end(), 0 );
+            }
+            if ( isHeard )
+                m_outputCount += m_hop;
+            else
+                --m_hopsToSkip;
+
+            m_prevPos = pos;
+            m_analysisPos += analysisHop;
+        }
+
+        // phase locked vocoder on one channel's spectrum ( re / im --> outRe / outIm )
+        void processSpectrum( channelState& ch, int hop )
+        {
+            const auto K = m_nBins;
+            const auto invN = Sample( 1 ) / static_cast< Sample >( m_fftSize );
+            const auto hopSamps = static_cast< Sample >( hop );
+            // synthesis phase advance per cycle of measured frequency
+            const auto advanceScale = static_cast< Sample >( m_hop ) * m_pitch;
+            const auto* re = ch.re.data();
+            const auto* im = ch.im.data();
+            auto* magnitude = ch.magnitude.data();
+            auto* phase = ch.phase.data();
+            auto* prevPhase = ch.prevPhase.data();
+            auto* advance = ch.advance.data();
+
+            // kept apart from the loop below, std::sqrt can set errno so this one does not vectorise without -fno-math-errno
+            for ( auto k = 0; k < K; ++k )
+                magnitude[ k ] = std::sqrt( re[ k ] * re[ k ] + im[ k ] * im[ k ] );
+            // phase and how far each bin's phase should move at the output if it turns out to be a peak
+            for ( auto k = 0; k < K; ++k )
+            {
+                phase[ k ] = maths::atan2Approx( im[ k ], re[ k ] ) * static_cast< Sample >( 0.5 / M_PI );
+                // difference from the phase the bin's centre frequency would have reached, wrapped to +/- 0.5 cycles
+                const auto expected = static_cast< Sample >( k ) * invN * hopSamps;
+                auto deviation = phase[ k ] - prevPhase[ k ] - expected;
+                deviation -= std::nearbyint( deviation );
+                advance[ k ] = ( expected + deviation ) / hopSamps * advanceScale;
+                prevPhase[ k ] = phase[ k ];
+            }
+
+            // peaks are louder than the two bins either side
+            auto nPeaks = 0;
+            for ( auto k = 0; k < K; ++k )
+            {
+                const auto m = magnitude[ k ];
+                if ( m > PEAK_THRESHOLD
+                    && ( k < 1 || m > magnitude[ k - 1 ] ) && ( k < 2 || m > magnitude[ k - 2 ] )
+                    && ( k > K - 2 || m >= magnitude[ k + 1 ] ) && ( k > K - 3 || m >= magnitude[ k + 2 ] ) )
+                    m_peaks[ nPeaks++ ] = k;
+            }
+            if ( nPeaks == 0 )
+                m_peaks[ nPeaks++ ] = static_cast< int >( std::max_element( magnitude, magnitude + K ) - magnitude );
+
+            if ( m_preserveFormants && m_pitch != 1 )
+                calculateEnvelope( ch, nPeaks );
+
+            // each region runs from half way to the previous peak to half way to the next one
+            auto* synthPhase = ch.synthPhase.data();
+            for ( auto p = 0; p < nPeaks; ++p )
+            {
+                const auto peak = m_peaks[ p ];
+                const auto lo = p == 0 ? 0 : ( m_peaks[ p - 1 ] + peak + 1 ) / 2;
+                const auto hi = p == nPeaks - 1 ? K : ( peak + m_peaks[ p + 1 ] + 1 ) / 2;
+                const auto peakPhase = wrapPhase( synthPhase[ peak ] + advance[ peak ] );
+                const auto offset = peakPhase - phase[ peak ];
+                for ( auto k = lo; k < hi; ++k )
+                    synthPhase[ k ] = phase[ k ] + offset;
+            }
+
+            auto* shiftedRe = ch.shiftedRe.data();
+            auto* shiftedIm = ch.shiftedIm.data();
+            for ( auto k = 0; k < K; ++k )
+            {
+                const auto cycles = wrapPhase( synthPhase[ k ] );
+                const auto sinCycles = wrapPhase( cycles - Sample( 0.25 ) ); // sin( 2 pi x ) == cos( 2 pi ( x - 0.25 ) )
+                shiftedRe[ k ] = magnitude[ k ] * maths::cosPhaseApprox( cycles );
+                shiftedIm[ k ] = magnitude[ k ] * maths::cosPhaseApprox( sinCycles );
+            }
+
+            // dc and nyquist must be real or they leak into the other channel of the pair
+            shiftedIm[ 0 ] = shiftedIm[ K - 1 ] = 0;
+            auto* outRe = ch.outRe.data();
+            auto* outIm = ch.outIm.data();
+            if ( m_pitch == 1 )
+            {
+                std::copy( shiftedRe, shiftedRe + K, outRe );
+                std::copy( shiftedIm, shiftedIm + K, outIm );
+                return;
+            }
+
+            // move each region by the distance between its peak's measured frequency and the scaled frequency, regions that land on the same bins are added together
+            // a shift of a fraction of a bin is a linear interpolation between two whole bin shifts,
+            // that only works with the phases measured from the centre of the frame, where neighbouring bins of a partial don't alternate in sign,
+            // measuring from the centre flips the sign of every odd bin, which cancels out to a sign of ( -1 )^wholeShift on each copy
+            std::fill( outRe, outRe + K, 0 );
+            std::fill( outIm, outIm + K, 0 );
+            const auto* envelope = ch.envelope.data();
+            auto* gain = ch.gain.data();
+            const auto binsPerAdvance = static_cast< Sample >( m_fftSize ) / advanceScale;
+            for ( auto p = 0; p < nPeaks; ++p )
+            {
+                const auto peak = m_peaks[ p ];
+                const auto lo = p == 0 ? 0 : ( m_peaks[ p - 1 ] + peak + 1 ) / 2;
+                const auto hi = p == nPeaks - 1 ? K : ( peak + m_peaks[ p + 1 ] + 1 ) / 2;
+                const auto peakBin = advance[ peak ] * binsPerAdvance;
+                const auto shift = peakBin * ( m_pitch - 1 );
+                const auto wholeShift = static_cast< int >( std::floor( shift ) );
+                const auto fraction = shift - wholeShift;
+                const auto sign = ( wholeShift % 2 == 0 ? Sample( 1 ) : Sample( -1 ) ) * getFractionGain( fraction );
+                const auto nearShift = fraction < Sample( 0.5 ) ? wholeShift : wholeShift + 1;
+                for ( auto k = lo; k < hi; ++k )
+                    gain[ k ] = sign;
+                if ( m_preserveFormants )
+                {
+                    for ( auto k = lo; k < hi; ++k )
+                    {
+                        const auto target = std::min( std::max( k + nearShift, 0 ), K - 1 );
+                        auto correction = envelope[ target ] - envelope[ k ];
+                        correction = std::abs( correction ) > MAX_FORMANT_CORRECTION ? std::copysign( MAX_FORMANT_CORRECTION, correction ) : correction;
+                        gain[ k ] *= maths::expApprox( correction );
+                    }
+                }
+                addShifted( ch, lo, hi, wholeShift, 1 - fraction );
+                addShifted( ch, lo, hi, wholeShift + 1, -fraction );
+            }
+            outIm[ 0 ] = outIm[ K - 1 ] = 0;
+        }
+
+        // wrap a phase in cycles to 0 --> 1, std::nearbyint vectorises where std::floor does not without -fno-trapping-math
+        static inline Sample wrapPhase( Sample cycles )
+        {
+            cycles -= std::nearbyint( cycles );
+            return cycles < 0 ? cycles + 1 : cycles;
+        }
+
+        Sample getFractionGain( Sample fraction ) const
+        {
+            const auto index = fraction * static_cast< Sample >( m_fractionGain.size() - 1 );
+            const auto i = std::min( static_cast< size_t >( index ), m_fractionGain.size() - 2 );
+            const auto mu = index - static_cast< Sample >( i );
+            return m_fractionGain[ i ] + mu * ( m_fractionGain[ i + 1 ] - m_fractionGain[ i ] );
+        }
+
+        // outRe / outIm [ k + shift ] += shiftedRe / shiftedIm [ k ] * gain[ k ] * weight for the bins of one region
+        void addShifted( channelState& ch, int lo, int hi, int shift, Sample weight )
+        {
+            lo = std::max( lo, -shift );
+            hi = std::min( hi, m_nBins - shift );
+            const auto* shiftedRe = ch.shiftedRe.data();
+            const auto* shiftedIm = ch.shiftedIm.data();
+            const auto* gain = ch.gain.data();
+            auto* outRe = ch.outRe.data() + shift;
+            auto* outIm = ch.outIm.data() + shift;
+            for ( auto k = lo; k < hi; ++k )
+            {
+                outRe[ k ] += shiftedRe[ k ] * gain[ k ] * weight;
+                outIm[ k ] += shiftedIm[ k ] * gain[ k ] * weight;
+            }
+        }
+
+        // log magnitude averaged over neighbouring bins, wide enough to smooth over the harmonics and leave the formants
+        void calculateEnvelope( channelState& ch, int nPeaks )
+        {
+            const auto K = m_nBins;
+            const auto* magnitude = ch.magnitude.data();
+            const auto loudest = *std::max_element( magnitude, magnitude + K );
+            // the width follows the spacing of the loud peaks ( the harmonics of a pitched sound ) so it just bridges the gaps between them
+            auto first = -1, last = -1, nLoud = 0;
+            for ( auto p = 0; p < nPeaks; ++p )
+            {
+                if ( magnitude[ m_peaks[ p ] ] < loudest * LOUD_PEAK )
+                    continue;
+                first = first < 0 ? m_peaks[ p ] : first;
+                last = m_peaks[ p ];
+                ++nLoud;
+            }
+            const auto spacing = nLoud > 1 ? static_cast< Sample >( last - first ) / ( nLoud - 1 ) : static_cast< Sample >( m_maxEnvelopeWidth );
+            const auto W = std::clamp( static_cast< int >( std::lround( spacing * ENVELOPE_WIDTH_PER_SPACING ) ), 1, m_maxEnvelopeWidth );
+            // the loudest bin within +/- W follows the tops of the partials rather than the gaps between them
+            auto* held = ch.logMagnitude.data();
+            std::copy( magnitude, magnitude + K, held );
+            for ( auto offset = 1; offset <= W && offset < K; ++offset )
+            {
+                for ( auto k = 0; k < K - offset; ++k )
+                    held[ k ] = std::max( held[ k ], magnitude[ k + offset ] );
+                for ( auto k = offset; k < K; ++k )
+                    held[ k ] = std::max( held[ k ], magnitude[ k - offset ] );
+            }
+            // bins far below the loudest are raised to a floor so silence does not give huge corrections
+            const auto floor = std::max( loudest * ENVELOPE_FLOOR, PEAK_THRESHOLD );
+            for ( auto k = 0; k < K; ++k )
+                held[ k ] = maths::logApprox( std::max( held[ k ], floor ) );
+            // then smoothed over the same width
+            auto* sum = m_envelopeSum.data();
+            sum[ 0 ] = 0;
+            for ( auto k = 0; k < K; ++k )
+                sum[ k + 1 ] = sum[ k ] + held[ k ];
+            auto* envelope = ch.envelope.data();
+            for ( auto k = 0; k < K; ++k )
+            {
+                const auto lo = std::max( k - W, 0 ), hi = std::min( k + W + 1, K );
+                envelope[ k ] = static_cast< Sample >( ( sum[ hi ] - sum[ lo ] ) / ( hi - lo ) );
+            }
+        }
+
+        sjf::spectral::fft< Sample > m_fft;
+        std::vector< std::complex< Sample > > m_fftBuffer;
+        std::vector< Sample > m_window;
+        std::vector< channelState > m_channels;
+        std::vector< int > m_peaks;
+        std::vector< double > m_envelopeSum;
+        std::array< Sample, 33 > m_fractionGain{};
+        Sample m_pitch = 1, m_stretch = 1, m_outputScale = 1;
+        double m_analysisPos = 0, m_analysisHop = 512;
+        int m_nChannels = 0, m_maxBlockSize = 0, m_fftSize = 2048, m_overlap = 4, m_hop = 512, m_nBins = 1025, m_maxEnvelopeWidth = 16, m_inputCapacity = 0;
+        int m_inputEnd = 0, m_prevPos = 0, m_outputCount = 0, m_hopsToSkip = 0;
+        bool m_preserveFormants = false, m_isFirstCall = true;
+    };
+}
+
+#endif /* sjf_phaseVocoder_h */
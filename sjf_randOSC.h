@@ -12,7 +12,7 @@
 template< class floatType >
 class sjf_randOSC
 {
-    floatType m_lastPhase = 1.0f,  m_currentTarget = 0.0f, m_lastTarget = 0.0f, m_diff, m_SR = 44100, m_increment;
+    floatType m_lastPhase = 1.0f,  m_currentTarget = 0.0f, m_lastTarget = 0.0f, m_diff = 0.0f, m_SR = 44100, m_increment;
     
 public:
     sjf_randOSC()
@@ -43,6 +43,18 @@ public:
         return calculateOutput( m_lastPhase + m_increment );
     }
     
+    /**
+     output for the current position and then move on by nSamples ( e.g. when only evaluated at control rate ), the same order as sjf_lfo::output( nSamples )
+     output() moves on first, so output( 1 ) is one sample behind it
+     nSamples * frequency must be less than the sample rate
+     */
+    floatType output( int nSamples )
+    {
+        auto out = m_lastTarget + ( m_lastPhase * m_diff );
+        calculateOutput( m_lastPhase + m_increment * nSamples );
+        return out;
+    }
+    
 private:
     floatType randomTarget()
     {
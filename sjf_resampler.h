@@ -0,0 +1,137 @@
+//
+//  sjf_resampler.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Offline high quality sample rate conversion.
+//  Kaiser windowed sinc interpolation using a finely sampled (polyphase) kernel table, intended for converting
+//  whole files once at load time rather than for use on the audio thread
+//
+
+#ifndef sjf_resampler_h
+#define sjf_resampler_h
+
+#include <cmath>
+#include <vector>
+#include <thread>
+
+namespace sjf::resampling
+{
+    /** zeroth order modified bessel function of the first kind ( for kaiser window ) */
+    inline double besselI0( double x )
+    {
+        double sum = 1, term = 1;
+        const auto halfX = x * 0.5;
+        for ( auto k = 1; k < 50; ++k )
+        {
+            term *= halfX / k;
+            auto t2 = term * term;
+            sum += t2;
+            if ( t2 < sum * 1e-12 )
+                break;
+        }
+        return sum;
+    }
+
+    /** length of the output needed to hold a signal of the given length resampled by ratio ( outputRate / inputRate ) */
+    inline size_t getResampledLength( size_t inputLength, double ratio )
+    {
+        return static_cast< size_t >( std::ceil( static_cast< double >( inputLength ) * ratio ) );
+    }
+
+    /**
+     Windowed sinc kernel for a particular conversion ratio
+     The kernel is stored as NPHASES points per input sample, intermediate positions are linearly interpolated between phases
+     When downsampling the kernel is widened so that the cutoff sits below the new nyquist
+     */
+    class sincKernel
+    {
+    public:
+        /**
+         ratio is outputRate / inputRate
+         halfTaps is the number of zero crossings either side of the centre ( quality vs speed )
+         */
+        sincKernel( double ratio, int halfTaps = 32, double kaiserBeta = 8.6 )
+        {
+            // cutoff relative to input nyquist, slightly below the lower of the two rates to leave room for the transition band
+            m_cutoff = ( ratio < 1.0 ? ratio : 1.0 ) * 0.95;
+            m_halfWidth = static_cast< int >( std::ceil( halfTaps / m_cutoff ) );
+            auto size = static_cast< size_t >( m_halfWidth ) * NPHASES + 2;
+            m_table.resize( size, 0.0 );
+            const auto i0Beta = besselI0( kaiserBeta );
+            for ( size_t i = 0; i < size; ++i )
+            {
+                auto x = static_cast< double >( i ) / NPHASES; // distance from centre in input samples
+                if ( x >= m_halfWidth )
+                    break;
+                auto r = x / m_halfWidth;
+                auto window = besselI0( kaiserBeta * std::sqrt( 1.0 - r*r ) ) / i0Beta;
+                auto arg = M_PI * x * m_cutoff;
+                auto sinc = ( x == 0 ) ? 1.0 : std::sin( arg ) / arg;
+                m_table[ i ] = m_cutoff * sinc * window;
+            }
+        }
+
+        /** number of input samples used either side of each output sample */
+        int getHalfWidth() const { return m_halfWidth; }
+
+        /** kernel value at a distance (in input samples) from the centre */
+        double operator()( double distance ) const
+        {
+            auto pos = std::abs( distance ) * NPHASES;
+            auto index = static_cast< size_t >( pos );
+            if ( index + 1 >= m_table.size() )
+                return 0;
+            auto mu = pos - index;
+            return m_table[ index ] + mu * ( m_table[ index + 1 ] - m_table[ index ] );
+        }
+
+    private:
+        static constexpr int NPHASES = 512;
+        double m_cutoff{ 0.95 };
+        int m_halfWidth{ 32 };
+        std::vector< double > m_table;
+    };
+
+    /**
+     Resample a single channel
+     ratio is outputRate / inputRate, signal beyond the ends of the input is treated as silence
+     */
+    template< typename Sample >
+    void resample( const Sample* input, size_t inputLength, Sample* output, size_t outputLength, double ratio, const sincKernel& kernel )
+    {
+        const auto halfWidth = kernel.getHalfWidth();
+        const auto step = 1.0 / ratio;
+        const auto lastIndex = static_cast< long >( inputLength ) - 1;
+        for ( size_t n = 0; n < outputLength; ++n )
+        {
+            auto centre = n * step;
+            auto i0 = static_cast< long >( std::floor( centre ) );
+            auto first = std::max( i0 - halfWidth + 1, 0l );
+            auto last = std::min( i0 + halfWidth, lastIndex );
+            double sum = 0;
+            for ( auto k = first; k <= last; ++k )
+                sum += input[ k ] * kernel( centre - k );
+            output[ n ] = static_cast< Sample >( sum );
+        }
+    }
+
+    /**
+     Resample several channels, each channel is converted on its own thread
+     inputs and outputs are arrays of channel pointers, outputs must hold at least outputLength samples
+     */
+    template< typename Sample >
+    void resample( const Sample* const* inputs, size_t inputLength, Sample* const* outputs, size_t outputLength, int nChannels, double ratio )
+    {
+        const sincKernel kernel( ratio );
+        if ( nChannels == 1 )
+            return resample( inputs[ 0 ], inputLength, outputs[ 0 ], outputLength, ratio, kernel );
+        std::vector< std::thread > threads;
+        for ( auto c = 0; c < nChannels; ++c )
+            threads.emplace_back( [ &, c ](){ resample( inputs[ c ], inputLength, outputs[ c ], outputLength, ratio, kernel ); } );
+        for ( auto& t : threads )
+            t.join();
+    }
+}
+
+#endif /* sjf_resampler_h */
@@ -15,6 +15,7 @@
 #include "sjf_randOSC.h"
 //#include "sjf_monoPitchShift.h"
 #include "sjf_pitchShift.h"
+#include "sjf_filters/sjf_smootherBank.h"
 #include <algorithm>    // std::random_erShuffle
 #include <random>       // std::default_random_engine
 #include <vector>
@@ -62,8 +63,10 @@ private:
     int m_SR = 44100; //, m_blockSize = 64;
 
     
-    T m_modulationTarget, m_sizeTarget, m_dryTarget = 0.89443f, m_wetTarget = 0.44721f, m_lrFBTarget = 0.85f, m_lrCutOffTarget = 0.8f, m_erCutOffTarget = 0.8f, m_shimmerTransposeTarget = 2.0f, m_shimmerLevelTarget = 0.4f;
-    sjf_lpf< T > m_sizeSmooth, m_fbSmooth, m_modSmooth, m_wetSmooth, m_drySmooth, m_lrCutOffSmooth, m_erCutOffSmooth, m_shimmerTransposeSmooth, m_shimmerLevelSmooth;
+    // control parameters are smoothed together, a chunk of samples at a time ( with the same one pole coefficients as the old per parameter sjf_lpf smoothers )
+    enum smoothedParams { size, feedback, modulation, wet, dry, lrCutOff, erCutOff, shimmerTranspose, shimmerLevel, NSMOOTHEDPARAMS };
+    static constexpr int SMOOTHING_BLOCK_SIZE = 64;
+    sjf::filters::smootherBank< T, NSMOOTHEDPARAMS, sjf::filters::smootherType::onepole > m_smoothers;
     
     
     bool m_feedbackControlFlag = false;
@@ -79,13 +82,22 @@ public:
     {
         srand((unsigned)time(NULL));
         
-        m_sizeSmooth.setCutoff( 0.001f );
-        m_fbSmooth.setCutoff( 0.001f );
-        m_modSmooth.setCutoff( 0.001f );
-        m_wetSmooth.setCutoff( 0.001f );
-        m_drySmooth.setCutoff( 0.001f );
-        m_lrCutOffSmooth.setCutoff( 0.0001f );
-        m_erCutOffSmooth.setCutoff( 0.0001f );
+        m_smoothers.prepare( SMOOTHING_BLOCK_SIZE );
+        m_smoothers.setCoefficient( 0.5f );
+        m_smoothers.setCoefficient( smoothedParams::size, 0.001f );
+        m_smoothers.setCoefficient( smoothedParams::feedback, 0.001f );
+        m_smoothers.setCoefficient( smoothedParams::modulation, 0.001f );
+        m_smoothers.setCoefficient( smoothedParams::wet, 0.001f );
+        m_smoothers.setCoefficient( smoothedParams::dry, 0.001f );
+        m_smoothers.setCoefficient( smoothedParams::lrCutOff, 0.0001f );
+        m_smoothers.setCoefficient( smoothedParams::erCutOff, 0.0001f );
+        m_smoothers.setTarget( smoothedParams::dry, 0.89443f );
+        m_smoothers.setTarget( smoothedParams::wet, 0.44721f );
+        m_smoothers.setTarget( smoothedParams::feedback, 0.85f );
+        m_smoothers.setTarget( smoothedParams::lrCutOff, 0.8f );
+        m_smoothers.setTarget( smoothedParams::erCutOff, 0.8f );
+        m_smoothers.setTarget( smoothedParams::shimmerTranspose, 2.0f );
+        m_smoothers.setTarget( smoothedParams::shimmerLevel, 0.4f );
         randomiseDelayTimes( );
         randomPolarityFlips( );
         randomiseModulators( );
@@ -120,20 +132,26 @@ public:
         static constexpr T shimLevelFactor = 1.0f / static_cast<T>(NUM_REV_CHANNELS);
         const T hadmardScale = std::sqrt( 1.0f / static_cast<T>(NUM_REV_CHANNELS) );
         const T dtScale = ( m_SR * 0.001f );
+        const T *sizeRamp = m_smoothers.getRamp( smoothedParams::size ), *fbRamp = m_smoothers.getRamp( smoothedParams::feedback ), *modRamp = m_smoothers.getRamp( smoothedParams::modulation );
+        const T *wetRamp = m_smoothers.getRamp( smoothedParams::wet ), *dryRamp = m_smoothers.getRamp( smoothedParams::dry );
+        const T *lrCutOffRamp = m_smoothers.getRamp( smoothedParams::lrCutOff ), *erCutOffRamp = m_smoothers.getRamp( smoothedParams::erCutOff );
         
         for ( int indexThroughCurrentBuffer = 0; indexThroughCurrentBuffer < bufferSize; ++indexThroughCurrentBuffer )
         {
             // first set up control variables
-
-            modFactor = m_modSmooth.filterInput( m_modulationTarget );
-            fbFactor = m_fbSmooth.filterInput( m_lrFBTarget );
-            size = m_sizeSmooth.filterInput( m_sizeTarget );
+            // smoothed parameters are calculated for a chunk of samples at a time
+            auto indexThroughChunk = indexThroughCurrentBuffer % SMOOTHING_BLOCK_SIZE;
+            if ( indexThroughChunk == 0 )
+                m_smoothers.process( std::min( SMOOTHING_BLOCK_SIZE, bufferSize - indexThroughCurrentBuffer ) );
+            modFactor = modRamp[ indexThroughChunk ];
+            fbFactor = fbRamp[ indexThroughChunk ];
+            size = sizeRamp[ indexThroughChunk ];
             erSizeFactor = ( 0.3f + (size * 0.7f) ) * dtScale;
             lrSizeFactor = ( 0.1f + (size * 0.9f) ) * dtScale;
-            lrCutOff = m_lrCutOffSmooth.filterInput( m_lrCutOffTarget );
-            erCutOff = m_erCutOffSmooth.filterInput( m_erCutOffTarget );
-            wet = m_wetSmooth.filterInput( m_wetTarget );
-            dry = m_drySmooth.filterInput( m_dryTarget );
+            lrCutOff = lrCutOffRamp[ indexThroughChunk ];
+            erCutOff = erCutOffRamp[ indexThroughChunk ];
+            wet = wetRamp[ indexThroughChunk ];
+            dry = dryRamp[ indexThroughChunk ];
             
             T sum = 0.0f; // reset sum
 
@@ -143,7 +161,7 @@ public:
                 sum += buffer.getSample( inC, indexThroughCurrentBuffer );
             }
             sum *= equalPowerGain;
-            sum += processShimmer( indexThroughCurrentBuffer, m_lastSummedOutput);
+            sum += processShimmer( indexThroughCurrentBuffer, indexThroughChunk, m_lastSummedOutput);
             erData.fill( sum );
 
             // early reflections
@@ -175,28 +193,27 @@ public:
     //==============================================================================
     void setSize ( const T &newSize )
     {
-        m_sizeTarget = pow(newSize * 0.01f, 2.0f);
-//        DBG( "m_sizeTarget " << m_sizeTarget );
+        m_smoothers.setTarget( smoothedParams::size, pow(newSize * 0.01f, 2.0f) );
     }
     //==============================================================================
     void setLrCutOff ( const T &newCutOff )
     {
-        m_lrCutOffTarget = newCutOff;
+        m_smoothers.setTarget( smoothedParams::lrCutOff, newCutOff );
     }
     //==============================================================================
     void setErCutOff ( const T &newCutOff )
     {
-        m_erCutOffTarget = newCutOff;
+        m_smoothers.setTarget( smoothedParams::erCutOff, newCutOff );
     }
     //==============================================================================
     void setDecay ( const T &newDecay )
     {
-        m_lrFBTarget = newDecay * 0.01f;
+        m_smoothers.setTarget( smoothedParams::feedback, newDecay * 0.01f );
     }
     //==============================================================================
     void setModulationDepth ( const T &newModulation )
     {
-        m_modulationTarget = newModulation * 0.005f; // +/- 50% of max delayTime
+        m_smoothers.setTarget( smoothedParams::modulation, newModulation * 0.005f ); // +/- 50% of max delayTime
     }
     //==============================================================================
     void setModulationRate( const T& newModRate )
@@ -207,19 +224,19 @@ public:
     void setMix ( const T &newMix )
     {
 //        newMix *= 0.01f;
-        m_wetTarget = sqrt( newMix * 0.01 );
-        m_dryTarget = sqrt( 1.0f - ( newMix * 0.01 ) );
+        m_smoothers.setTarget( smoothedParams::wet, sqrt( newMix * 0.01 ) );
+        m_smoothers.setTarget( smoothedParams::dry, sqrt( 1.0f - ( newMix * 0.01 ) ) );
     }
     //==============================================================================
     void setShimmerLevel ( const T &newShimmerLevel )
     {
 //        newShimmerLevel *= 0.01f;
-        m_shimmerLevelTarget = pow( newShimmerLevel * 0.01, 2.0f );
+        m_smoothers.setTarget( smoothedParams::shimmerLevel, pow( newShimmerLevel * 0.01, 2.0f ) );
     }
 
     void setShimmerTransposition( const T &newShimmerTransposition )
     {
-        m_shimTranspose = pow( 2.0f, ( newShimmerTransposition / 12.0f ) );
+        m_smoothers.setTarget( smoothedParams::shimmerTranspose, pow( 2.0f, ( newShimmerTransposition / 12.0f ) ) );
     }
     //==============================================================================
     void setInterpolationType( const int &interpolationType )
@@ -242,11 +259,11 @@ public:
     
 private:
     //==============================================================================
-    T processShimmer( const int &indexThroughCurrentBuffer, const T &inVal )
+    T processShimmer( const int &indexThroughCurrentBuffer, const int &indexThroughChunk, const T &inVal )
     {
         // shimmer
         shimmer.setSample( indexThroughCurrentBuffer, inVal );
-        return shimmer.pitchShiftOutput( indexThroughCurrentBuffer, m_shimmerTransposeSmooth.filterInput( m_shimmerTransposeTarget ) ) * m_shimmerLevelSmooth.filterInput( m_shimmerLevelTarget );
+        return shimmer.pitchShiftOutput( indexThroughCurrentBuffer, m_smoothers.getRamp( smoothedParams::shimmerTranspose )[ indexThroughChunk ] ) * m_smoothers.getRamp( smoothedParams::shimmerLevel )[ indexThroughChunk ];
     }
     
     //==============================================================================
@@ -62,7 +62,7 @@ public:
     
 private:
     static constexpr int TABLE_SIZE = 1024;
-    sinArray< T, TABLE_SIZE > m_osc;
+    static constexpr const sinArray< T, TABLE_SIZE >& m_osc = sjf_sinTable< T, TABLE_SIZE >;
     
     int m_interpolationType = sjf_interpolators::pureData;
     T m_readPos = 0;
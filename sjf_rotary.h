@@ -33,7 +33,7 @@ private:
     std::array< sjf_lpf< T >, NCHANNELS > m_lpfs;
     std::array< T, NBANDS > m_rotationMultiples = { 0.5, 2 };
     T m_baseF = 0.5, m_rotRatio = 1, m_Xtalk = 0.7;
-    sjf_sinArray< T, TABLESIZE > m_sinArr;
+    static constexpr const sjf_sinArray< T, TABLESIZE >& m_sinArr = sjf_sinTable< T, TABLESIZE >;
     
     
 public:
@@ -0,0 +1,321 @@
+//
+//  sjf_sampleCache.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Process wide, reference counted cache of decoded audio files.
+//  Each file is decoded once into a float scratch file in the temp directory which is then memory mapped,
+//  so every instance that loads the same file shares the same pages
+//  The most recently used files are kept for a while after their last user lets go ( up to a size limit ),
+//  so reopening a preset or switching back to a sample that was just used doesn't decode it again
+//
+
+#ifndef sjf_sampleCache_h
+#define sjf_sampleCache_h
+
+#include <JuceHeader.h>
+#include "sjf_resampler.h"
+#include <algorithm>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace sjf::sampleCache
+{
+    /**
+     A single decoded audio file stored planar (one channel after the other) in a memory mapped scratch file
+     Sample data is READ ONLY!!! Anything that needs to alter the audio should make a copy first
+     */
+    class cachedSample
+    {
+    public:
+        cachedSample( const juce::File& scratchFile, int nChannels, int nSamples, double sampleRate ) :
+            m_scratchFile( scratchFile ), m_nChannels( nChannels ), m_nSamples( nSamples ), m_sampleRate( sampleRate )
+        {
+            m_map = std::make_unique< juce::MemoryMappedFile >( m_scratchFile, juce::MemoryMappedFile::readOnly );
+            if ( m_map->getData() == nullptr )
+                return;
+            auto data = static_cast< float* >( m_map->getData() );
+            for ( auto c = 0; c < m_nChannels; ++c )
+                m_channels.push_back( data + ( static_cast< size_t >( c ) * m_nSamples ) );
+        }
+
+        ~cachedSample()
+        {
+            m_map.reset(); // unmap before deleting the file
+            m_scratchFile.deleteFile();
+        }
+
+        /** returns true if the scratch file was mapped succesfully */
+        bool isValid() const { return static_cast< int >( m_channels.size() ) == m_nChannels; }
+
+        int getNumChannels() const { return m_nChannels; }
+        int getNumSamples() const { return m_nSamples; }
+        double getSampleRate() const { return m_sampleRate; }
+
+        /** direct access to the mapped sample data for a single channel */
+        const float* getReadPointer( int channel ) const
+        {
+            assert( channel >= 0 && channel < m_nChannels );
+            return m_channels[ channel ];
+        }
+
+        /**
+         Returns an AudioBuffer that refers directly to the mapped data ( nothing is copied ).
+         Move assign the result into your own buffer to avoid juce making a copy.
+         The buffer is only valid while this cachedSample is alive and must never be written to
+         */
+        juce::AudioBuffer< float > getBuffer() const
+        {
+            return juce::AudioBuffer< float >( m_channels.data(), m_nChannels, m_nSamples );
+        }
+
+    private:
+        juce::File m_scratchFile;
+        std::unique_ptr< juce::MemoryMappedFile > m_map;
+        std::vector< float* > m_channels;
+        int m_nChannels{ 0 }, m_nSamples{ 0 };
+        double m_sampleRate{ 44100 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( cachedSample )
+    };
+
+    /** shared handle to a cached sample, the sample (and its scratch file) is released when the last handle goes */
+    using samplePtr = std::shared_ptr< const cachedSample >;
+
+    //==============//==============//==============//==============//==============//==============
+    //==============//==============//==============//==============//==============//==============
+    //==============//==============//==============//==============//==============//==============
+    //==============//==============//==============//==============//==============//==============
+    /**
+     Cache of decoded files keyed by full path, modification time and sample rate
+     Use sjf::sampleCache::load() rather than creating your own instance
+     */
+    class cache
+    {
+    public:
+        /**
+         Returns a shared handle to the decoded file, decoding it first if it is not already in the cache.
+         If a target sample rate is given files recorded at a different rate are converted to it once when they are decoded,
+         so they can be played back without any rate compensation
+         The cache is only locked to look up and publish entries, files are decoded with it unlocked so different files load in parallel.
+         A request for a file that is already being decoded waits for that decode rather than starting another
+         Returns nullptr if the file cannot be read
+         */
+        samplePtr load( const juce::File& file, juce::AudioFormatManager& formatManager, double targetSampleRate = 0 )
+        {
+            if ( !file.existsAsFile() )
+                return nullptr;
+            auto key = makeKey( file, targetSampleRate );
+            std::promise< samplePtr > decoding;
+            std::shared_future< samplePtr > inFlight;
+            juce::File scratch;
+            {
+                std::vector< samplePtr > evicted; // released after the lock
+                std::lock_guard< std::mutex > lock( m_mutex );
+                auto& entry = m_samples[ key ];
+                if ( auto existing = entry.sample.lock() )
+                {
+                    markRecentlyUsed( existing, evicted );
+                    return existing;
+                }
+                if ( entry.inFlight.valid() )
+                    inFlight = entry.inFlight;
+                else
+                {
+                    entry.inFlight = decoding.get_future().share();
+                    // the scratch file is created while locked so two decodes can never be given the same name
+                    scratch = juce::File::getSpecialLocation( juce::File::tempDirectory ).getNonexistentChildFile( "sjf_sampleCache", ".f32", false );
+                    scratch.create();
+                }
+            }
+            if ( inFlight.valid() )
+                return inFlight.get(); // someone else is already decoding this file
+            samplePtr decoded;
+            try
+            {
+                decoded = decode( file, scratch, formatManager, targetSampleRate );
+            }
+            catch ( ... )
+            {
+                scratch.deleteFile();
+                finishDecode( key, nullptr );
+                decoding.set_exception( std::current_exception() );
+                throw;
+            }
+            if ( decoded == nullptr )
+                scratch.deleteFile();
+            finishDecode( key, decoded );
+            decoding.set_value( decoded );
+            return decoded;
+        }
+
+        /**
+         Set the total size of the recently used samples that are kept alive after nothing else holds them
+         0 means a sample is released as soon as its last user lets go
+         */
+        void setRecentlyUsedLimit( size_t bytes )
+        {
+            std::vector< samplePtr > evicted;
+            std::lock_guard< std::mutex > lock( m_mutex );
+            m_recentLimit = bytes;
+            trimRecentlyUsed( evicted );
+        }
+
+        /** Stop keeping any recently used samples alive, samples that are still in use are not affected */
+        void clearRecentlyUsed()
+        {
+            std::vector< samplePtr > evicted;
+            std::lock_guard< std::mutex > lock( m_mutex );
+            evicted.assign( m_recent.begin(), m_recent.end() );
+            m_recent.clear();
+            m_recentBytes = 0;
+        }
+
+        /** number of files currently held in the cache */
+        size_t getNumCachedSamples()
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            removeExpired();
+            return m_samples.size();
+        }
+
+    private:
+        static juce::String makeKey( const juce::File& file, double targetSampleRate )
+        {
+            return file.getFullPathName() + "@" + juce::String( file.getLastModificationTime().toMilliseconds() ) + "@" + juce::String( targetSampleRate );
+        }
+
+        struct entry
+        {
+            std::weak_ptr< const cachedSample > sample;
+            std::shared_future< samplePtr > inFlight; // only valid while the file is being decoded
+        };
+
+        /** publish the result of a decode and stop other requests waiting on it */
+        void finishDecode( const juce::String& key, const samplePtr& decoded )
+        {
+            std::vector< samplePtr > evicted;
+            std::lock_guard< std::mutex > lock( m_mutex );
+            auto& entry = m_samples[ key ];
+            entry.inFlight = {};
+            entry.sample = decoded;
+            if ( decoded != nullptr )
+                markRecentlyUsed( decoded, evicted );
+            removeExpired();
+        }
+
+        static size_t getSizeInBytes( const samplePtr& sample )
+        {
+            return static_cast< size_t >( sample->getNumChannels() ) * static_cast< size_t >( sample->getNumSamples() ) * sizeof( float );
+        }
+
+        /** move a sample to the front of the recently used list, call with m_mutex locked */
+        void markRecentlyUsed( const samplePtr& sample, std::vector< samplePtr >& evicted )
+        {
+            auto it = std::find( m_recent.begin(), m_recent.end(), sample );
+            if ( it == m_recent.end() )
+            {
+                m_recent.push_front( sample );
+                m_recentBytes += getSizeInBytes( sample );
+            }
+            else
+                m_recent.splice( m_recent.begin(), m_recent, it );
+            trimRecentlyUsed( evicted );
+        }
+
+        /** drop the least recently used samples until the list is within its limit, they are handed to evicted so they can be released after unlocking */
+        void trimRecentlyUsed( std::vector< samplePtr >& evicted )
+        {
+            while ( m_recentBytes > m_recentLimit && !m_recent.empty() )
+            {
+                m_recentBytes -= getSizeInBytes( m_recent.back() );
+                evicted.push_back( std::move( m_recent.back() ) );
+                m_recent.pop_back();
+            }
+        }
+
+        void removeExpired()
+        {
+            for ( auto it = m_samples.begin(); it != m_samples.end(); )
+                it = ( it->second.sample.expired() && !it->second.inFlight.valid() ) ? m_samples.erase( it ) : std::next( it );
+        }
+
+        /** decodes into scratch, which must already exist and be empty */
+        static samplePtr decode( const juce::File& file, const juce::File& scratch, juce::AudioFormatManager& formatManager, double targetSampleRate )
+        {
+            std::unique_ptr< juce::AudioFormatReader > reader ( formatManager.createReaderFor( file ) );
+            if ( reader.get() == nullptr || reader->lengthInSamples < 1 || reader->numChannels < 1 )
+                return nullptr;
+            auto nChannels = static_cast< int >( reader->numChannels );
+            auto nSamples = static_cast< int >( reader->lengthInSamples );
+            auto sampleRate = reader->sampleRate;
+            {
+                juce::FileOutputStream out( scratch );
+                if ( out.failedToOpen() )
+                    return nullptr;
+                if ( targetSampleRate > 0 && sampleRate != targetSampleRate )
+                {
+                    // conversion needs the whole file in memory, this only happens once per file and rate
+                    juce::AudioBuffer< float > original( nChannels, nSamples );
+                    reader->read( &original, 0, nSamples, 0, true, true );
+                    auto ratio = targetSampleRate / sampleRate;
+                    auto nResampled = static_cast< int >( sjf::resampling::getResampledLength( nSamples, ratio ) );
+                    juce::AudioBuffer< float > resampled( nChannels, nResampled );
+                    sjf::resampling::resample( original.getArrayOfReadPointers(), nSamples, resampled.getArrayOfWritePointers(), nResampled, nChannels, ratio );
+                    for ( auto c = 0; c < nChannels; ++c )
+                        out.write( resampled.getReadPointer( c ), nResampled * sizeof( float ) );
+                    nSamples = nResampled;
+                    sampleRate = targetSampleRate;
+                }
+                else
+                {
+                    juce::AudioBuffer< float > chunk( nChannels, CHUNK_SIZE );
+                    const auto bytesPerChannel = static_cast< juce::int64 >( nSamples ) * sizeof( float );
+                    for ( auto start = 0; start < nSamples; start += CHUNK_SIZE )
+                    {
+                        auto n = std::min( CHUNK_SIZE, nSamples - start );
+                        reader->read( &chunk, 0, n, start, true, true );
+                        for ( auto c = 0; c < nChannels; ++c )
+                        {
+                            out.setPosition( c * bytesPerChannel + static_cast< juce::int64 >( start ) * sizeof( float ) );
+                            out.write( chunk.getReadPointer( c ), n * sizeof( float ) );
+                        }
+                    }
+                }
+                out.flush();
+                if ( out.getStatus().failed() )
+                    return nullptr;
+            }
+            auto sample = std::make_shared< cachedSample >( scratch, nChannels, nSamples, sampleRate );
+            if ( !sample->isValid() )
+                return nullptr;
+            return sample;
+        }
+
+        static constexpr int CHUNK_SIZE = 65536;
+        static constexpr size_t DEFAULT_RECENTLY_USED_LIMIT = 256 * 1024 * 1024;
+        std::mutex m_mutex;
+        std::map< juce::String, entry > m_samples;
+        std::list< samplePtr > m_recent; // strong references to the most recently used samples, most recent first
+        size_t m_recentBytes{ 0 }, m_recentLimit{ DEFAULT_RECENTLY_USED_LIMIT };
+    };
+
+    //==============//==============//==============//==============//==============//==============
+    /** the single cache shared by everything in this process */
+    inline cache& getCache()
+    {
+        static cache theCache;
+        return theCache;
+    }
+
+    /** load a file through the process wide cache, optionally converting it to the target sample rate */
+    inline samplePtr load( const juce::File& file, juce::AudioFormatManager& formatManager, double targetSampleRate = 0 )
+    {
+        return getCache().load( file, formatManager, targetSampleRate );
+    }
+}
+
+#endif /* sjf_sampleCache_h */
@@ -0,0 +1,220 @@
+//
+//  sjf_sampleLoader.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Background loading of audio files for classes that play them back on the audio thread.
+//  Files are decoded (through sjf_sampleCache) on a worker thread, handed to the audio thread with an atomic pointer swap
+//  and the sample they replace is released back on the worker thread, so the audio thread never waits, allocates or frees
+//
+
+#ifndef sjf_sampleLoader_h
+#define sjf_sampleLoader_h
+
+#include <JuceHeader.h>
+#include "sjf_sampleCache.h"
+#include <atomic>
+#include <mutex>
+
+namespace sjf::sampleCache
+{
+    /**
+     Loads samples into a number of slots (e.g. one per voice) without blocking the audio thread
+        --> load() or publish() from any non-audio thread
+        --> call update() for each slot at the start of each block on the audio thread, then read with getCurrent()
+        --> onLoaded is called on the message thread once each request has finished
+     Classes that only use onLoaded ( and never call update() ) should call setPublishesToSlots( false ),
+     otherwise each loaded sample sits in its slot's pending entry, holding a reference to it, until the next load
+     */
+    class asyncLoader : private juce::Thread, private juce::AsyncUpdater
+    {
+    public:
+        /** A decoded sample as seen by the audio thread */
+        struct loadedSample
+        {
+            samplePtr data;
+            juce::File file;
+        };
+
+        asyncLoader( juce::AudioFormatManager& formatManager, size_t nSlots = 1 ) : juce::Thread( "sjf_sampleLoader" ), m_formatManager( formatManager )
+        {
+            setNumSlots( nSlots );
+            startThread();
+        }
+
+        ~asyncLoader()
+        {
+            cancelPendingUpdate();
+            stopThread( 2000 );
+            releaseRetired();
+            for ( auto& s : m_slots )
+            {
+                delete s->pending.exchange( nullptr );
+                delete s->current;
+            }
+        }
+
+        /** Set the number of slots available. Do not call this while the audio thread is using the loader */
+        void setNumSlots( size_t nSlots )
+        {
+            std::lock_guard< std::mutex > lock( m_slotMutex );
+            while ( m_slots.size() > nSlots )
+            {
+                delete m_slots.back()->pending.exchange( nullptr );
+                delete m_slots.back()->current;
+                m_slots.pop_back();
+            }
+            while ( m_slots.size() < nSlots )
+                m_slots.push_back( std::make_unique< slot >() );
+        }
+
+        size_t getNumSlots() const { return m_slots.size(); }
+
+        /** Files loaded after this is called will be converted to this sample rate as they are decoded ( 0 leaves them at their original rate ) */
+        void setTargetSampleRate( double sampleRate ) { m_targetSampleRate = sampleRate; }
+        
+        double getTargetSampleRate() const { return m_targetSampleRate; }
+
+        /** false stops samples decoded by load() being handed to the slots, for classes that only use onLoaded */
+        void setPublishesToSlots( bool shouldPublish ) { m_publishToSlots = shouldPublish; }
+
+        /** Request a file to be decoded on the background thread and handed to the given slot */
+        void load( size_t slotNumber, const juce::File& file )
+        {
+            {
+                std::lock_guard< std::mutex > lock( m_requestMutex );
+                m_requests.push_back( { slotNumber, file, nullptr } );
+            }
+            notify();
+        }
+
+        /** Hand an already decoded sample to the given slot (e.g. after a synchronous load). Not for use on the audio thread */
+        void publish( size_t slotNumber, samplePtr data, const juce::File& file )
+        {
+            auto fresh = new loadedSample{ std::move( data ), file };
+            std::lock_guard< std::mutex > lock( m_slotMutex );
+            if ( slotNumber >= m_slots.size() )
+            {
+                delete fresh;
+                return;
+            }
+            // anything still pending was never seen by the audio thread so can be released straight away
+            delete m_slots[ slotNumber ]->pending.exchange( fresh, std::memory_order_acq_rel );
+        }
+
+        /**
+         AUDIO THREAD
+         Swaps in any newly loaded sample for the given slot, returns true if the slot changed.
+         The previous sample is passed back to the worker thread to be released
+         */
+        bool update( size_t slotNumber )
+        {
+            auto& s = *m_slots[ slotNumber ];
+            if ( s.pending.load( std::memory_order_relaxed ) == nullptr )
+                return false;
+            if ( m_retiredFifo.getFreeSpace() < 1 )
+                return false; // worker hasn't caught up yet, try again next block
+            auto fresh = s.pending.exchange( nullptr, std::memory_order_acq_rel );
+            if ( fresh == nullptr )
+                return false;
+            if ( s.current != nullptr )
+            {
+                const auto scope = m_retiredFifo.write( 1 );
+                if ( scope.blockSize1 > 0 )
+                    m_retired[ static_cast< size_t >( scope.startIndex1 ) ] = s.current;
+            }
+            s.current = fresh;
+            return true;
+        }
+
+        /** AUDIO THREAD --> the sample currently in use by the given slot (nullptr if nothing has been loaded) */
+        const loadedSample* getCurrent( size_t slotNumber ) const { return m_slots[ slotNumber ]->current; }
+
+        /** Called on the message thread after each request, data is nullptr if the file could not be read */
+        std::function< void( size_t slotNumber, samplePtr data, const juce::File& file ) > onLoaded;
+
+    private:
+        struct slot
+        {
+            std::atomic< loadedSample* > pending{ nullptr };
+            loadedSample* current{ nullptr }; // only touched by the audio thread
+        };
+
+        struct request
+        {
+            size_t slotNumber;
+            juce::File file;
+            samplePtr data;
+        };
+
+        void run() override
+        {
+            while ( !threadShouldExit() )
+            {
+                releaseRetired();
+                request next;
+                {
+                    std::lock_guard< std::mutex > lock( m_requestMutex );
+                    if ( m_requests.empty() )
+                        next.slotNumber = NO_REQUEST;
+                    else
+                    {
+                        next = m_requests.front();
+                        m_requests.erase( m_requests.begin() );
+                    }
+                }
+                if ( next.slotNumber == NO_REQUEST )
+                {
+                    wait( 50 ); // also the rate at which retired samples are released
+                    continue;
+                }
+                next.data = sjf::sampleCache::load( next.file, m_formatManager, m_targetSampleRate );
+                if ( next.data != nullptr && m_publishToSlots )
+                    publish( next.slotNumber, next.data, next.file );
+                {
+                    std::lock_guard< std::mutex > lock( m_completedMutex );
+                    m_completed.push_back( next );
+                }
+                triggerAsyncUpdate();
+            }
+        }
+
+        void handleAsyncUpdate() override
+        {
+            std::vector< request > completed;
+            {
+                std::lock_guard< std::mutex > lock( m_completedMutex );
+                completed.swap( m_completed );
+            }
+            if ( !onLoaded )
+                return;
+            for ( auto& c : completed )
+                onLoaded( c.slotNumber, c.data, c.file );
+        }
+
+        void releaseRetired()
+        {
+            const auto scope = m_retiredFifo.read( m_retiredFifo.getNumReady() );
+            for ( auto i = 0; i < scope.blockSize1; ++i )
+                delete m_retired[ static_cast< size_t >( scope.startIndex1 + i ) ];
+            for ( auto i = 0; i < scope.blockSize2; ++i )
+                delete m_retired[ static_cast< size_t >( scope.startIndex2 + i ) ];
+        }
+
+        static constexpr size_t NO_REQUEST = std::numeric_limits< size_t >::max();
+        static constexpr int RETIRED_SIZE = 64;
+
+        juce::AudioFormatManager& m_formatManager;
+        std::atomic< double > m_targetSampleRate{ 0 };
+        std::atomic< bool > m_publishToSlots{ true };
+        std::vector< std::unique_ptr< slot > > m_slots;
+        std::mutex m_slotMutex, m_requestMutex, m_completedMutex;
+        std::vector< request > m_requests, m_completed;
+        juce::AbstractFifo m_retiredFifo{ RETIRED_SIZE };
+        std::array< loadedSample*, RETIRED_SIZE > m_retired{};
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( asyncLoader )
+    };
+}
+
+#endif /* sjf_sampleLoader_h */
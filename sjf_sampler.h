@@ -10,6 +10,7 @@
 #include <vector>
 #include "sjf_audioUtilities.h"
 #include "sjf_interpolationTypes.h"
+#include "sjf_sampleLoader.h"
 #include <time.h>
 
 class sjf_sampler{
@@ -19,6 +20,12 @@ public:
     {
         m_AudioSample.clear();
         m_formatManager.registerBasicFormats();
+        m_loader.onLoaded = [ this ]( size_t, sjf::sampleCache::samplePtr data, const juce::File& file )
+        {
+            if ( data == nullptr ){ return; }
+            m_samplePath = file.getFullPathName();
+            m_sampleName = file.getFileName();
+        };
         setPatterns();
     };
     
@@ -28,6 +35,10 @@ public:
     {
         m_SR  = sampleRate;
         srand((unsigned)time(NULL));
+        if ( m_loader.getTargetSampleRate() == sampleRate ){ return; }
+        // samples are converted to the session rate when they are loaded so reload if the rate has changed
+        m_loader.setTargetSampleRate( sampleRate );
+        reloadSample();
     }
     
     //==============================================================================
@@ -46,47 +57,37 @@ public:
                               {
                                   auto file = fc.getResult();
                                   if (file == juce::File{}) { return; }
-                                  std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-                                  if (reader.get() != nullptr)
-                                  {
-                                      bool lastPlayState = m_canPlayFlag;
-                                      m_canPlayFlag = false;
-                                      m_tempBuffer.clear();
-                                      m_tempBuffer.setSize( static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples) );
-                                      m_durationSamps = m_tempBuffer.getNumSamples();
-                                      reader->read (&m_tempBuffer, 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-                                      //                                          m_AudioSample.clear();
-                                      m_AudioSample.makeCopyOf(m_tempBuffer);
-                                      m_sliceLenSamps = m_durationSamps / static_cast<float>(m_nSlices);
-                                      //                                          setPatterns();
-                                      m_samplePath = file.getFullPathName();
-                                      m_sampleName = file.getFileName();
-                                      m_tempBuffer.setSize(0, 0);
-                                      m_sampleLoadedFlag = true;
-                                      m_canPlayFlag = lastPlayState;
-                                  }
+                                  m_loader.load( 0, file ); // decoded in the background, the sample changes at the start of the next block
                               });
     };
     //==============================================================================
+    /** Decodes the file straight away, the sample changes over at the start of the next block */
     void loadSample(juce::Value path)
     {
         juce::File file( path.getValue().toString() );
         if (file == juce::File{}) { return; }
-        std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-        if (reader.get() != nullptr)
-        {
-            m_AudioSample.clear();
-            m_AudioSample.setSize( static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples) );
-            m_durationSamps = m_AudioSample.getNumSamples();
-            reader->read (&m_AudioSample, 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-            m_sliceLenSamps = m_durationSamps/m_nSlices;
-            setPatterns();
-            m_samplePath = file.getFullPathName();
-            m_sampleName = file.getFileName();
-            m_sampleLoadedFlag = true;
-        }
+        auto cached = sjf::sampleCache::load( file, m_formatManager, m_loader.getTargetSampleRate() );
+        if ( cached == nullptr ){ return; }
+        m_loader.publish( 0, cached, file );
+        setPatterns();
+        m_samplePath = file.getFullPathName();
+        m_sampleName = file.getFileName();
     };
     //==============================================================================
+    /**
+     AUDIO THREAD
+     Swaps in a sample that has finished loading since the last block, call this at the start of each block before playing.
+     The sample it replaces is released by the loader's worker thread once the audio thread has stopped reading it
+     */
+    void updateLoadedSample()
+    {
+        if ( !m_loader.update( 0 ) ){ return; }
+        m_AudioSample = m_loader.getCurrent( 0 )->data->getBuffer();
+        m_durationSamps = m_AudioSample.getNumSamples();
+        m_sliceLenSamps = m_durationSamps / static_cast<float>( m_nSlices );
+        m_sampleLoadedFlag = true;
+    }
+    //==============================================================================
     const juce::String getFilePath()
     {
         return m_samplePath;
@@ -157,6 +158,7 @@ public:
     //==============================================================================
     void play(juce::AudioBuffer<float> &buffer)
     {
+        updateLoadedSample();
         if ( !m_canPlayFlag ){ return; }
         if (!m_sampleLoadedFlag) { return; }
         auto envLen = m_phaseRateMultiplier * m_fadeInMs * m_SR / 1000;
@@ -197,6 +199,7 @@ public:
     //==============================================================================
     void play(juce::AudioBuffer<float> &buffer, float bpm, double hostPosition)
     {
+        updateLoadedSample();
         if ( !m_canPlayFlag ){ return; }
         if (!m_sampleLoadedFlag) { return; }
         auto bufferSize = buffer.getNumSamples();
@@ -300,6 +303,12 @@ public:
     };
     //==============================================================================
 private:
+    // decode the current file again ( e.g. at a new sample rate ), only the sample and its duration change, the patterns are left alone
+    void reloadSample()
+    {
+        if ( m_samplePath.isNotEmpty() ){ m_loader.load( 0, juce::File( m_samplePath ) ); }
+    }
+    //==============================================================================
     bool checkForChangeOfBeat(int currentStep)
     {
         bool newStep = false;
@@ -325,7 +334,7 @@ private:
             outVal = 1 - (pos - sampsAtEnd)/envLen;
         }
         //        return outVal; // this would give linear fade
-        return sin( PI* (outVal)/2 ); // this gives a smooth sinewave based fade
+        return sin( M_PI * (outVal)/2 ); // this gives a smooth sinewave based fade
     };
     //==============================================================================
     float calculateReverse(int currentStep, float pos, float subDivLenSamps)
@@ -532,8 +541,9 @@ protected:
     
     int m_nSteps = 16; int m_nSlices = 16;
     
-    juce::AudioBuffer<float> m_AudioSample, m_tempBuffer;
+    juce::AudioBuffer<float> m_AudioSample, m_tempBuffer; // m_AudioSample refers to the sample data owned by m_loader
     juce::AudioFormatManager m_formatManager;
+    sjf::sampleCache::asyncLoader m_loader{ m_formatManager };
     std::unique_ptr<juce::FileChooser> m_chooser;
     
     float m_fadeInMs = 1;
@@ -10,6 +10,7 @@
 #include <vector>
 #include "sjf_audioUtilities.h"
 #include "sjf_interpolationTypes.h"
+#include "sjf_sampleLoader.h"
 #include <time.h>
 
 class sjf_samplerPoly
@@ -35,10 +36,11 @@ protected:
     int m_nSteps = 16;
     float m_phaseRateMultiplier = 1;
     
-    std::vector< juce::AudioBuffer<float> > m_AudioSample;
+    std::vector< juce::AudioBuffer<float> > m_AudioSample; // refers to the sample data owned by m_loader
     juce::AudioBuffer<float> m_tempBuffer;
     
     juce::AudioFormatManager m_formatManager;
+    sjf::sampleCache::asyncLoader m_loader{ m_formatManager };
     std::unique_ptr<juce::FileChooser> m_chooser;
     
     float m_fadeInMs = 1;
@@ -52,6 +54,9 @@ protected:
     float m_readPos = 0;
     int m_stepCount = 0;
     
+    static constexpr int SPAN_SIZE = 256;
+    std::array< float, SPAN_SIZE > m_spanPos, m_spanEnv; // per sample read positions and envelope for the span being rendered
+    
 public:
     sjf_samplerPoly()
     {
@@ -61,6 +66,12 @@ public:
             m_AudioSample[ voiceNumber ].clear();
         }
         m_formatManager.registerBasicFormats();
+        m_loader.onLoaded = [ this ]( size_t voiceNumber, sjf::sampleCache::samplePtr data, const juce::File& file )
+        {
+            if ( data == nullptr || voiceNumber >= m_samplePath.size() ){ return; }
+            m_samplePath[ voiceNumber ] = file.getFullPathName();
+            m_sampleName[ voiceNumber ] = file.getFileName();
+        };
         setPatterns();
     };
     
@@ -70,12 +81,20 @@ public:
     {
         m_SR  = sampleRate;
         srand((unsigned)time(NULL));
+        if ( m_loader.getTargetSampleRate() == sampleRate ){ return; }
+        // samples are converted to the session rate when they are loaded so reload anything already loaded at another rate
+        m_loader.setTargetSampleRate( sampleRate );
+        for ( int voiceNumber = 0; voiceNumber < m_samplePath.size(); voiceNumber++ )
+        {
+            if ( m_samplePath[ voiceNumber ].isNotEmpty() ){ m_loader.load( voiceNumber, juce::File( m_samplePath[ voiceNumber ] ) ); }
+        }
     }
     
     void setNumVoices( const int& nVoices )
     {
         if( m_AudioSample.size() == nVoices ){ return; }
         m_AudioSample.resize( nVoices );
+        m_loader.setNumSlots( nVoices );
         m_samplePath.resize( nVoices );
         m_sampleName.resize( nVoices );
         m_stepPat.resize( nVoices );
@@ -121,57 +140,37 @@ public:
                                                          juce::File{}, "*.aif, *.wav");
         auto chooserFlags = juce::FileBrowserComponent::openMode
         | juce::FileBrowserComponent::canSelectFiles;
-        bool sampleFlag = false;
-        m_chooser->launchAsync (chooserFlags, [this, voiceNumber, &sampleFlag] (const juce::FileChooser& fc)
+        m_chooser->launchAsync (chooserFlags, [this, voiceNumber] (const juce::FileChooser& fc)
                                 {
             auto file = fc.getResult();
-            if (file == juce::File{}) { return false; }
-            std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-            if (reader.get() != nullptr)
-            {
-                bool lastPlayState = m_canPlayFlag;
-                m_canPlayFlag = false;
-                m_tempBuffer.clear();
-                m_tempBuffer.setSize( static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples) );
-                m_durationSamps[ voiceNumber ] = m_tempBuffer.getNumSamples();
-                reader->read (&m_tempBuffer, 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-                //                                          m_AudioSample.clear();
-                m_AudioSample[ voiceNumber ].makeCopyOf(m_tempBuffer);
-                m_sliceLenSamps[ voiceNumber ] = m_durationSamps[ voiceNumber ] / static_cast<float>(m_nSlices[ voiceNumber ]);
-                //                                          setPatterns();
-                m_samplePath[ voiceNumber ] = file.getFullPathName();
-                m_sampleName[ voiceNumber ] = file.getFileName();
-                m_tempBuffer.setSize(0, 0);
-                m_sampleLoadedFlag[ voiceNumber ] = true;
-                m_canPlayFlag = lastPlayState;
-                sampleFlag = true;
-            }
+            if (file == juce::File{}) { return; }
+            m_loader.load( voiceNumber, file ); // decoded in the background, the voice changes at the start of the next block
         });
-        if (sampleFlag) {return true; }
-        else { return false; }
+        return false;
     };
     //==============================================================================
+    /** Decodes the file straight away, the voice changes over at the start of the next block */
     bool loadSample(juce::Value path, const int& voiceNumber)
     {
         juce::File file( path.getValue().toString() );
         if (file == juce::File{}) { return false; }
-        std::unique_ptr<juce::AudioFormatReader> reader (m_formatManager.createReaderFor (file));
-        if (reader.get() != nullptr)
-        {
-            m_AudioSample[ voiceNumber ].clear();
-            m_AudioSample[ voiceNumber ].setSize( static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples) );
-            m_durationSamps[ voiceNumber ] = m_AudioSample[ voiceNumber ].getNumSamples();
-            reader->read (&m_AudioSample[ voiceNumber ], 0, static_cast<int>(reader->lengthInSamples), 0, true, true);
-            m_sliceLenSamps[ voiceNumber ] = m_durationSamps[ voiceNumber ]/m_nSlices[ voiceNumber ];
-            setPatterns();
-            m_samplePath[ voiceNumber ] = file.getFullPathName();
-            m_sampleName[ voiceNumber ] = file.getFileName();
-            m_sampleLoadedFlag[ voiceNumber ] = true;
-        }
-        else{ return false; }
+        auto cached = sjf::sampleCache::load( file, m_formatManager, m_loader.getTargetSampleRate() );
+        if ( cached == nullptr ){ return false; }
+        m_loader.publish( voiceNumber, cached, file );
+        setPatterns();
+        m_samplePath[ voiceNumber ] = file.getFullPathName();
+        m_sampleName[ voiceNumber ] = file.getFileName();
         return true;
     };
     //==============================================================================
+    /** Decodes the file on a background thread, the voice changes over at the start of the first block after it has finished */
+    void loadSampleAsync(juce::Value path, const int& voiceNumber)
+    {
+        juce::File file( path.getValue().toString() );
+        if (file == juce::File{}) { return; }
+        m_loader.load( voiceNumber, file );
+    };
+    //==============================================================================
     const juce::String getFilePath( const int voiceNumber )
     {
         return m_samplePath[ voiceNumber ];
@@ -265,6 +264,7 @@ public:
     //==============================================================================
     void play(juce::AudioBuffer<float> &buffer)
     {
+        updateLoadedSamples();
         if ( !m_canPlayFlag ){ return; }
         if (!m_sampleLoadedFlag[ m_voiceNumber ])
         {
@@ -281,11 +281,11 @@ public:
         }
 
         auto bufferSize = buffer.getNumSamples();
-        auto numChannels = buffer.getNumChannels();
         
         auto increment = m_phaseRateMultiplier;
         auto envLen = static_cast<int>( m_phaseRateMultiplier * m_fadeInMs * m_SR / 1000 ) + 1;
-        for (int index = 0; index < bufferSize; index++)
+        int index = 0;
+        while ( index < bufferSize )
         {
             if ( checkForChangeOfBeat( m_stepCount ) )
             {
@@ -308,26 +308,7 @@ public:
                 increment = m_phaseRateMultiplier;
             }
             
-            auto pos = m_readPos;
-            auto subDiv = floor(m_subDivPat[m_stepCount] * 8.0f) + 1.0f ;
-            auto subDivLenSamps = m_sliceLenSamps[ m_voiceNumber ] / subDiv ;
-            auto subDivAmp = calculateSubDivAmp( m_stepCount, subDiv, int(pos / subDivLenSamps) );
-            auto speedVal = calculateSpeedVal( m_stepCount, (m_readPos / m_sliceLenSamps[ m_voiceNumber ]) );
-            while (pos >= subDivLenSamps){ pos -= subDivLenSamps; }
-            auto env = envelope( pos , static_cast<int>(subDivLenSamps) - 1, envLen ); // Check this out more
-            auto amp = calculateAmpValue( m_stepCount );
-            pos = calculateReverse( m_stepCount, pos, subDivLenSamps );
-            pos *= speedVal;
-            pos += m_stepPat[ m_voiceNumber ][ m_stepCount ] * m_sliceLenSamps[ m_voiceNumber ];
-            
-            for (int channel = 0; channel < numChannels; channel ++)
-            {
-                auto val = calculateSampleValue( m_AudioSample[ m_voiceNumber ], channel % m_AudioSample[ m_voiceNumber ].getNumChannels(), pos );
-                val *= subDivAmp * amp;
-                val *= env;
-                buffer.setSample(channel, index, val);
-            }
-            m_readPos += increment;
+            index += renderSpan( buffer, index, bufferSize - index, increment, envLen, false );
             if (m_readPos >= m_sliceLenSamps[ m_voiceNumber ]) {m_stepCount++; m_stepCount %= m_nSteps; }
             while (m_readPos >= m_sliceLenSamps[ m_voiceNumber ]){ m_readPos -= m_sliceLenSamps[ m_voiceNumber ]; }
         }
@@ -335,6 +316,7 @@ public:
     //==============================================================================
     void play(juce::AudioBuffer<float> &buffer, float bpm, double hostPosition)
     {
+        updateLoadedSamples();
         if ( !m_canPlayFlag ){ return; }
         m_voiceNumber %= m_sampleLoadedFlag.size();
         if ( !m_sampleLoadedFlag[ m_voiceNumber ] )
@@ -351,7 +333,6 @@ public:
             if ( !samples ){ return; }
         }
         auto bufferSize = buffer.getNumSamples();
-        auto numChannels = buffer.getNumChannels();
         
         auto envLen = floor(m_fadeInMs * m_SR / 1000) + 1;
         auto hostSampQuarter = 60.0f*m_SR/bpm;
@@ -364,7 +345,8 @@ public:
         fastMod3< float > ( m_readPos, m_sliceLenSamps[ m_voiceNumber ] );
         fastMod3< int >( m_stepCount, m_nSteps );
 
-        for (int index = 0; index < bufferSize; index++)
+        int index = 0;
+        while ( index < bufferSize )
         {
             if ( checkForChangeOfBeat( m_stepCount ) )
             {
@@ -392,37 +374,13 @@ public:
                 fastMod3< int >( m_stepCount, m_nSteps );
             }
 
-
-
-            auto pos = m_readPos;
-            auto subDiv = floor( m_subDivPat[ m_stepCount ] * 8.0f ) + 1.0f ;
-            auto subDivLenSamps = m_sliceLenSamps[ m_voiceNumber ] / subDiv ;
-            auto subDivAmp = calculateSubDivAmp( m_stepCount, subDiv, int(pos / subDivLenSamps) );
-            auto speedVal = calculateSpeedVal( m_stepCount, ( m_readPos / m_sliceLenSamps[ m_voiceNumber ] ) );
-            fastMod3< float >( pos, subDivLenSamps ); //while ( pos >= subDivLenSamps ){ pos -= subDivLenSamps; }
-            auto env = envelope( floor( pos / increment ) , floor( subDivLenSamps / increment ), envLen ); // Check this out more
-            auto amp = calculateAmpValue( m_stepCount );
-            pos = calculateReverse( m_stepCount, pos, subDivLenSamps );
-            pos *= speedVal;
-            pos += m_stepPat[ m_voiceNumber ][ m_stepCount ] * m_sliceLenSamps[ m_voiceNumber ];
-            
-            for (int channel = 0; channel < numChannels; channel ++)
-            {
-                auto val = calculateSampleValue( m_AudioSample[ m_voiceNumber ], channel % m_AudioSample[ m_voiceNumber ].getNumChannels(), pos );
-                val *= subDivAmp * amp;
-                val *= env;
-                buffer.setSample(channel, index, val);
-            }
-            m_readPos +=  increment;
+            index += renderSpan( buffer, index, bufferSize - index, increment, envLen, true );
             if ( m_readPos >= m_sliceLenSamps[ m_voiceNumber ] )
             {
                 m_stepCount++;
                 m_stepCount %= m_nSteps;
                 fastMod3< float > ( m_readPos, m_sliceLenSamps[ m_voiceNumber ] );
             }
-//            while (m_readPos >= m_sliceLenSamps[ m_voiceNumber ])
-//            { m_readPos -= m_sliceLenSamps[ m_voiceNumber ]; }
-            
         }
     }
     //==============================================================================
@@ -467,6 +425,93 @@ private:
 //        return pos;
 //
 //    }
+    //==============================================================================
+    // Renders from the current read position up to the end of the current subdivision (or the end of the block/span)
+    // Everything that is constant within a subdivision is calculated once, the read positions and envelope are
+    // calculated for the whole span and then each channel is interpolated and scaled in one go
+    // returns the number of samples written and leaves m_readPos at the position following the span
+    int renderSpan( juce::AudioBuffer<float>& buffer, const int startSample, const int maxSamples, const float increment, const float envLen, const bool hostSynced )
+    {
+        const auto sliceLen = m_sliceLenSamps[ m_voiceNumber ];
+        const auto subDiv = floor( m_subDivPat[ m_stepCount ] * 8.0f ) + 1.0f;
+        const auto subDivLenSamps = sliceLen / subDiv;
+        const auto subDivCount = static_cast<int>( m_readPos / subDivLenSamps );
+        const auto subDivStart = subDivCount * subDivLenSamps;
+        const auto gain = calculateSubDivAmp( m_stepCount, subDiv, subDivCount ) * calculateAmpValue( m_stepCount );
+        const auto reverse = m_revPat[ m_stepCount ] >= 0.25;
+        const auto offset = m_stepPat[ m_voiceNumber ][ m_stepCount ] * sliceLen;
+        const auto envPeriod = hostSynced ? floor( subDivLenSamps / increment ) : static_cast<int>( subDivLenSamps ) - 1;
+        
+        auto nSamps = static_cast<int>( std::ceil( ( subDivStart + subDivLenSamps - m_readPos ) / increment ) );
+        nSamps = std::max( 1, std::min( { nSamps, maxSamples, SPAN_SIZE } ) );
+        
+        // speed ramps exponentially across the slice so can be advanced with a single multiply
+        auto speed = calculateSpeedVal( m_stepCount, m_readPos / sliceLen );
+        const auto speedRatio = m_speedRampFlag ? std::pow( 2.0f, m_speedPat[ m_stepCount ] * increment / sliceLen ) : 1.0f;
+        auto hasEnv = false;
+        auto readPos = m_readPos;
+        for ( int s = 0; s < nSamps; s++ )
+        {
+            auto pos = readPos - subDivStart;
+            auto envPos = hostSynced ? floor( pos / increment ) : pos;
+            if ( envPos < envLen || envPos > envPeriod - envLen )
+            {
+                m_spanEnv[ s ] = envelope( envPos, envPeriod, envLen );
+                hasEnv = true;
+            }
+            else { m_spanEnv[ s ] = 1.0f; }
+            m_spanPos[ s ] = ( reverse ? subDivLenSamps - pos : pos ) * speed + offset;
+            speed *= speedRatio;
+            readPos += increment;
+        }
+        m_readPos = readPos;
+        
+        const auto& sample = m_AudioSample[ m_voiceNumber ];
+        const auto nSampleChannels = sample.getNumChannels();
+        for ( int channel = 0; channel < buffer.getNumChannels(); channel++ )
+        {
+            auto dest = buffer.getWritePointer( channel, startSample );
+            interpolateSpan( sample.getReadPointer( channel % nSampleChannels ), sample.getNumSamples(), dest, nSamps );
+            if ( hasEnv ){ juce::FloatVectorOperations::multiply( dest, m_spanEnv.data(), nSamps ); }
+            juce::FloatVectorOperations::multiply( dest, gain, nSamps );
+        }
+        return nSamps;
+    }
+    //==============================================================================
+    // chooses the interpolation once per span rather than once per sample
+    void interpolateSpan( const float* samples, const int bufferSize, float* dest, const int nSamps )
+    {
+        if (m_interpolationType < 1) { m_interpolationType = 1; }
+        else if (m_interpolationType > 6) { m_interpolationType = 6; }
+        switch(m_interpolationType)
+        {
+            case 1:
+                return ::interpolateSpan< 1 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+            case 2:
+                return ::interpolateSpan< 2 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+            case 3:
+                return ::interpolateSpan< 3 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+            case 4:
+                return ::interpolateSpan< 4 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+            case 5:
+                return ::interpolateSpan< 5 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+            case 6:
+                return ::interpolateSpan< 6 >( samples, bufferSize, m_spanPos.data(), dest, nSamps );
+        }
+    }
+    //==============================================================================
+    // swap in any samples that have finished loading since the last block
+    void updateLoadedSamples()
+    {
+        for ( size_t voiceNumber = 0; voiceNumber < m_AudioSample.size(); voiceNumber++ )
+        {
+            if ( !m_loader.update( voiceNumber ) ){ continue; }
+            m_AudioSample[ voiceNumber ] = m_loader.getCurrent( voiceNumber )->data->getBuffer();
+            m_durationSamps[ voiceNumber ] = m_AudioSample[ voiceNumber ].getNumSamples();
+            m_sliceLenSamps[ voiceNumber ] = m_durationSamps[ voiceNumber ] / static_cast<float>( m_nSlices[ voiceNumber ] );
+            m_sampleLoadedFlag[ voiceNumber ] = true;
+        }
+    }
     //==============================================================================
     bool checkForChangeOfBeat( int currentStep )
     {
@@ -8,7 +8,19 @@
 #define sjf_sola_h
 
 #include <JuceHeader.h>
+#include <atomic>
+#include <complex>
 #include "sjf_audioUtilities.h"
+#include "sjf_fft.h"
+
+/**
+ Offline SOLA time stretching
+ Each segment of the stretched sample only depends on the original sample, so segments are split into batches that are shared between
+ the calling thread and the threads of a juce::ThreadPool ( the threads are kept between calls, not started for each one )
+ The cross correlation used to line up each overlap is calculated directly for small overlaps and with an fft for large ones,
+ both give the same values ( to within rounding ) so the choice of path does not change the lags that are chosen
+ For stretching in real time see sjf::timestretch::wsola in sjf_wsola.h
+ */
 template< typename T >
 class sjf_sola
 {
@@ -16,7 +28,13 @@ public:
 //    sjf_sola(){}
 //    ~sjf_sola(){}
     
-    static inline void stretch( juce::AudioBuffer< T > &sampleToStretch, juce::AudioBuffer< T > &stretchedSample, T stretchFactor, int N = 2048, int hopSize = 256, int fadeType = linear )
+    /**
+     Stretch a sample into stretchedSample, sampleToStretch is not changed
+        nThreads --> number of threads to share the segments between including the calling thread, 0 uses one per cpu
+        threadPool --> where the other threads come from, nullptr uses getSharedThreadPool()
+     Don't call this from a job running on the same pool, it waits for the jobs it adds
+     */
+    static inline void stretch( const juce::AudioBuffer< T > &sampleToStretch, juce::AudioBuffer< T > &stretchedSample, T stretchFactor, int N = 2048, int hopSize = 256, int fadeType = linear, int nThreads = 0, juce::ThreadPool* threadPool = nullptr )
     {
         if ( sampleToStretch.getNumSamples() == 0 )
             return;
@@ -34,17 +52,22 @@ public:
         
         auto Sa = std::min( hopSize,  static_cast< int >( N / ( stretchFactor * 4 ) ) );
 //        auto Sa = hopSize;
-        auto M = std::ceil( static_cast< T >( originalSize ) / ( static_cast< T > ( Sa ) ) );
-        // zero pad sample so last blocks don't run over edge
+        auto M = static_cast< int >( std::ceil( static_cast< T >( originalSize ) / ( static_cast< T > ( Sa ) ) ) );
+        // zero padded copy of the sample so last blocks don't run over edge
         auto newSize = ( M * Sa ) + N;
-        sampleToStretch.setSize( sampleToStretch.getNumChannels(), newSize, true, true, true );
+        juce::AudioBuffer< T > padded( nChannels, newSize );
+        for ( auto c = 0; c < nChannels; c++ )
+        {
+            padded.copyFrom( c, 0, sampleToStretch, c, 0, originalSize );
+            padded.clear( c, originalSize, newSize - originalSize );
+        }
         
-        auto Ss = std::ceil( Sa * stretchFactor );
+        auto Ss = static_cast< int >( std::ceil( Sa * stretchFactor ) );
         // slightly larger than necessary so we don't run into overruns
         stretchedSample.setSize( nChannels, Ss * M, true, true, true );
         
 //        auto L = std::min( static_cast< int >( Ss / 2 ), static_cast< int >( Sa / 2 ) );
-        auto L = static_cast< int >( Ss / 2 );
+        auto L = Ss / 2;
         auto norm = 1.0 / static_cast< T >( L );
         // create fade for between sections
         std::vector< T > fade;
@@ -64,81 +87,172 @@ public:
                 break;
         }
         
+        // pointers are fetched once here, juce::AudioBuffer::getWritePointer is not safe to call from several threads
+        std::vector< const T* > readPointers( nChannels );
+        std::vector< T* > writePointers( nChannels );
+        for ( auto c = 0; c < nChannels; c++ )
+        {
+            readPointers[ c ] = padded.getReadPointer( c );
+            writePointers[ c ] = stretchedSample.getWritePointer( c );
+        }
         
         // start by writing first block to stretchedBuffer
         // 0 --> Ss samples
         for ( auto c = 0; c < nChannels; c++ )
-            stretchedSample.copyFrom( c, 0, sampleToStretch, c, 0, Ss );
-        int solaIndex = Ss;
-        int fadeIndexIn, fadeIndexOut ;
-        T fadeIn, fadeOut, sampVal;
-        for ( auto b = 1; b < M; b++ )
+            std::copy( readPointers[ c ], readPointers[ c ] + Ss, writePointers[ c ] );
+        
+        const auto useFFT = L >= FFT_CORRELATION_THRESHOLD;
+        fft< double > transform;
+        if ( useFFT )
+            transform.prepare( sjf::spectral::nextPowerOf2( 2 * L ) );
+        
+        // segments 1 --> M-1 are handed out in batches
+        std::atomic< int > nextBatch{ 1 };
+        auto worker = [ & ]()
         {
-            // calculate cross correlation between end of block A and beginning of block B
-            //      Block A overlap start is (b-1)*Sa + Ss
-            auto blockAIndex = (b-1)*Sa + Ss;
-            //      block B start is b*Sa
-            auto blockBIndex = b*Sa;
-            auto timeLag = calculateCrossCorrelationTimeLag( sampleToStretch, blockAIndex, blockBIndex, L, norm );
-            // then do fade out of block A as block B fades in
-            //      and copy to stretched sample buffer
-            auto crossOverLength = timeLag + L;
-            for ( auto s = 0; s < crossOverLength; s++ )
+            std::vector< std::complex< double > > spectrum, crossSpectrum;
+            if ( useFFT )
             {
-                fadeIndexIn = s - timeLag;
-                fadeIndexOut = L - fadeIndexIn;
-                fadeIn = fadeIndexIn < 0 ? 0 : fadeIndexIn < L ? fade[ fadeIndexIn ] : 1;
-                fadeOut = fadeIndexOut < 0 ? 0 : fadeIndexOut < L ? fade[ fadeIndexOut ] : 1;
-//                auto segAIndex = blockAOverlapStart + s;
-//                auto segBIndex = blockBStart + s;
-                for ( auto c = 0; c < nChannels; c++ )
-                {
-                    sampVal = fadeOut <= 0 ? 0 : sampleToStretch.getSample( c, blockAIndex ) * fadeOut;
-                    sampVal += fadeIn <= 0 ? 0 : sampleToStretch.getSample( c, blockBIndex ) * fadeIn;
-                    stretchedSample.setSample( c, solaIndex, sampVal );
-                }
-                blockAIndex++;
-                blockBIndex++;
-                solaIndex++;
+                spectrum.resize( transform.getSize() );
+                crossSpectrum.resize( transform.getSize() );
             }
-            // then copy (Ss-crossoverLength) samples from block B to stretched sample buffer
-            // block B becomes block A for next loop
-            for ( auto s = 0; s < Ss - crossOverLength; s++ )
+            for ( auto first = nextBatch.fetch_add( BATCH_SIZE ); first < M; first = nextBatch.fetch_add( BATCH_SIZE ) )
             {
-//                auto segBIndex = blockBStart + timeLag + L + s;
-                for ( auto c = 0; c < nChannels; c++ )
-                    stretchedSample.setSample( c, solaIndex, sampleToStretch.getSample( c, blockBIndex ) );
-                solaIndex++;
-                blockBIndex++;
+                auto last = std::min( first + BATCH_SIZE, M );
+                for ( auto b = first; b < last; b++ )
+                {
+                    // calculate cross correlation between end of block A and beginning of block B
+                    //      Block A overlap start is (b-1)*Sa + Ss
+                    auto blockAIndex = (b-1)*Sa + Ss;
+                    //      block B start is b*Sa
+                    auto blockBIndex = b*Sa;
+                    auto timeLag = useFFT ?
+                        calculateCrossCorrelationTimeLagFFT( readPointers, blockAIndex, blockBIndex, L, transform, spectrum, crossSpectrum ) :
+                        calculateCrossCorrelationTimeLag( readPointers, blockAIndex, blockBIndex, L, norm );
+                    writeSegment( readPointers, writePointers, blockAIndex, blockBIndex, b * Ss, Ss, L, timeLag, fade );
+                }
             }
-        }
-        // resize samples
-        sampleToStretch.setSize( sampleToStretch.getNumChannels(), originalSize, true, true, true );
+        };
+        
+        if ( nThreads <= 0 )
+            nThreads = juce::SystemStats::getNumCpus();
+        nThreads = std::min( nThreads, ( M - 1 + BATCH_SIZE - 1 ) / BATCH_SIZE );
+        if ( nThreads > 1 && threadPool == nullptr )
+            threadPool = &getSharedThreadPool();
+        // the calling thread works through batches as well, then waits for the pool jobs to finish theirs
+        std::atomic< int > nRunning{ nThreads - 1 };
+        juce::WaitableEvent finished;
+        for ( auto t = 1; t < nThreads; t++ )
+            threadPool->addJob( [ & ]()
+                               {
+                                   worker();
+                                   if ( --nRunning == 0 )
+                                       finished.signal();
+                               } );
+        worker();
+        if ( nThreads > 1 )
+            finished.wait();
         stretchedSample.setSize( nChannels, stretchSize, true, true, true );
     }
     
+    /** The pool stretch() uses when it isn't given one, created on first use with one thread per cpu apart from the calling thread */
+    static juce::ThreadPool& getSharedThreadPool()
+    {
+        static juce::ThreadPool pool( std::max( juce::SystemStats::getNumCpus() - 1, 1 ) );
+        return pool;
+    }
+    
  
     enum fadeTypes
     { linear, hann };
     
 private:
+    template< typename Sample >
+    using fft = sjf::spectral::fft< Sample >;
+    
+    // below this overlap the direct calculation is quicker
+    static constexpr int FFT_CORRELATION_THRESHOLD = 64;
+    // segments handed to a thread at a time
+    static constexpr int BATCH_SIZE = 64;
     
-    static inline auto calculateCrossCorrelationTimeLag( juce::AudioBuffer< T > &sampleToStretch, int segStartA, int segStartB, int L, T norm )
+    // fade out of block A as block B fades in, then copy the rest of block B
+    // each segment writes exactly Ss samples starting at solaIndex
+    static inline void writeSegment( const std::vector< const T* >& readPointers, const std::vector< T* >& writePointers, int blockAIndex, int blockBIndex, int solaIndex, int Ss, int L, int timeLag, const std::vector< T >& fade )
+    {
+        auto crossOverLength = timeLag + L;
+        for ( size_t c = 0; c < readPointers.size(); c++ )
+        {
+            auto segA = readPointers[ c ] + blockAIndex;
+            auto segB = readPointers[ c ] + blockBIndex;
+            auto out = writePointers[ c ] + solaIndex;
+            // before the lag only block A is heard
+            std::copy( segA, segA + timeLag, out );
+            // the fade in starts at 0 and the fade out at 1
+            out[ timeLag ] = segA[ timeLag ];
+            for ( auto s = timeLag + 1; s < crossOverLength; s++ )
+            {
+                auto fadeIndexIn = s - timeLag;
+                out[ s ] = segA[ s ] * fade[ L - fadeIndexIn ] + segB[ s ] * fade[ fadeIndexIn ];
+            }
+            std::copy( segB + crossOverLength, segB + Ss, out + crossOverLength );
+        }
+    }
+    
+    static inline int calculateCrossCorrelationTimeLag( const std::vector< const T* >& readPointers, int segStartA, int segStartB, int L, T norm )
     {
-        auto nChannels = sampleToStretch.getNumChannels();
-
         auto maxIndex = 0;
         auto maxVal = -10000.0f; // default arbitrarily low value
         T newVal = 0;
         for ( auto i = 0; i < L; i++ )
         {
             newVal = 0;
-            for ( auto c = 0; c < nChannels; c++ )
+            for ( auto rp : readPointers )
+                newVal += crossCorrelation( rp + segStartA, rp + segStartB + i, L-i ) * norm;
+            if ( newVal > maxVal )
             {
-                auto rpA = sampleToStretch.getReadPointer( c, segStartA );
-                auto rpB = sampleToStretch.getReadPointer( c, segStartB+i );
-                newVal += crossCorrelation( rpA, rpB, L-i ) * norm;
+                maxIndex = i;
+                maxVal = newVal;
             }
+        }
+        return maxIndex;
+    }
+    
+    /**
+     The same cross correlation as calculateCrossCorrelationTimeLag() calculated as ifft( conj( A ) * B ) with both segments zero padded to twice their length
+     Both segments of a channel go through one complex fft as A + iB and are separated using the symmetry of the spectrum of a real signal,
+     the cross spectra of all channels are summed so only one inverse fft is needed
+     */
+    static inline int calculateCrossCorrelationTimeLagFFT( const std::vector< const T* >& readPointers, int segStartA, int segStartB, int L, const fft< double >& transform, std::vector< std::complex< double > >& spectrum, std::vector< std::complex< double > >& crossSpectrum )
+    {
+        const auto P = transform.getSize();
+        std::fill( crossSpectrum.begin(), crossSpectrum.end(), std::complex< double >( 0, 0 ) );
+        for ( auto rp : readPointers )
+        {
+            auto segA = rp + segStartA, segB = rp + segStartB;
+            for ( auto i = 0; i < L; i++ )
+                spectrum[ i ] = std::complex< double >( segA[ i ], segB[ i ] );
+            std::fill( spectrum.begin() + L, spectrum.end(), std::complex< double >( 0, 0 ) );
+            transform.perform( spectrum, false );
+            for ( size_t k = 0; k < P; k++ )
+            {
+                // A[ k ] = ( Z[ k ] + conj( Z[ -k ] ) ) / 2, B[ k ] = ( Z[ k ] - conj( Z[ -k ] ) ) / 2i
+                // conj( A ) * B * 4i = ( conj( Z[ k ] ) + Z[ -k ] ) * ( Z[ k ] - conj( Z[ -k ] ) ) = |Z[ k ]|^2 - |Z[ -k ]|^2 + 2i * imag( Z[ -k ] * Z[ k ] )
+                const auto& z = spectrum[ k ];
+                const auto& zm = spectrum[ ( P - k ) & ( P - 1 ) ];
+                auto re = z.real() * z.real() + z.imag() * z.imag() - zm.real() * zm.real() - zm.imag() * zm.imag();
+                auto im = 2.0 * ( zm.real() * z.imag() + zm.imag() * z.real() );
+                // divide by 4i
+                crossSpectrum[ k ] += std::complex< double >( im * 0.25, -re * 0.25 );
+            }
+        }
+        transform.perform( crossSpectrum, true );
+        // the inverse is not scaled, fold 1 / P into the normalisation
+        const auto norm = 1.0 / ( static_cast< double >( L ) * static_cast< double >( P ) );
+        auto maxIndex = 0;
+        auto maxVal = -10000.0; // default arbitrarily low value
+        for ( auto i = 0; i < L; i++ )
+        {
+            auto newVal = crossSpectrum[ i ].real() * norm;
             if ( newVal > maxVal )
             {
                 maxIndex = i;
@@ -63,8 +63,8 @@ private:
     static constexpr int TABLE_SIZE = 1024;
     sjf_hilbert< T > m_hilbert;
     sjf_phasor< T > m_phasor;
-    sjf_sinArray< T, TABLE_SIZE > m_sinArray;
-    sjf_cosArray< T, TABLE_SIZE > m_cosArray;
+    static constexpr const sjf_sinArray< T, TABLE_SIZE >& m_sinArray = sjf_sinTable< T, TABLE_SIZE >;
+    static constexpr const sjf_cosArray< T, TABLE_SIZE >& m_cosArray = sjf_cosTable< T, TABLE_SIZE >;
     T m_fShift;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_ssb )
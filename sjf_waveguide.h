@@ -12,13 +12,27 @@
 #include "sjf_audioUtilitiesC++.h"
 #include "sjf_lpf.h"
 #include "sjf_waveshapers.h"
+#include "sjf_mathsApproximations.h"
 
 #include "gcem/include/gcem.hpp"
 
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #define MINIMUM_FREQUENCY 5.0
 
+// in single precision the delay lines calculate their read position with an error of up to half an ulp of the write position
+// delays within that distance of a whole number of samples are snapped to it so the integer part of the read position is always correct
+// ( for double this makes no audible difference )
+template < class T >
+inline T sjf_waveguideSafeDelay( double delayInSamps, double maxDelayInSamps )
+{
+    auto whole = std::round( delayInSamps );
+    return static_cast< T >( std::abs( delayInSamps - whole ) <= maxDelayInSamps * std::numeric_limits< T >::epsilon() ? whole : delayInSamps );
+}
+
 //==============================================
 //==============================================
 //==============================================
@@ -66,7 +80,8 @@ public:
     
     void prepare( T sampleRate )
     {
-        m_delayLine.initialise( sampleRate / MINIMUM_FREQUENCY );
+        m_maxDelayInSamps = sampleRate / MINIMUM_FREQUENCY;
+        m_delayLine.initialise( m_maxDelayInSamps );
         clear();
     }
     
@@ -91,9 +106,9 @@ public:
         return sensorOut;
     }
     
-    void setDelayInSamps( T totalDelayInSamps )
+    void setDelayInSamps( double totalDelayInSamps )
     {
-        m_delayInSamps = totalDelayInSamps;
+        m_delayInSamps = sjf_waveguideSafeDelay< T >( totalDelayInSamps, m_maxDelayInSamps );
         m_delayLine.setDelayTimeSamps( m_delayInSamps );
         setSensorPosition( m_sensorPosition );
     }
@@ -104,7 +119,7 @@ public:
         assert( sensorPos > 0 && sensorPos < 1 );
 #endif
         m_sensorPosition = sensorPos;
-        m_sensorDelay = m_delayInSamps * m_sensorPosition;
+        m_sensorDelay = sjf_waveguideSafeDelay< T >( static_cast< double >( m_delayInSamps ) * m_sensorPosition, m_maxDelayInSamps );
         m_delayLine.setTapTime( m_tapNum, m_sensorDelay );
     }
     
@@ -117,8 +132,9 @@ public:
     }
     
 private:
-    sjf_delayLine< double > m_delayLine;
+    sjf_delayLine< T > m_delayLine;
     T m_delayInSamps = 4410, m_sensorPosition = 0.5 , /* m_pickPosition = 0.25, */ m_g = 0;
+    double m_maxDelayInSamps = 44100 / MINIMUM_FREQUENCY;
     T m_sensorDelay = m_delayInSamps * m_sensorPosition;
     
     static constexpr int m_tapNum = 0;
@@ -144,6 +160,14 @@ public:
     
     ~sjf_pmExcitation(){}
     
+    // reserve enough space for the longest period so new notes don't allocate
+    void prepare( T sampleRate )
+    {
+        auto maxPeriod = static_cast< size_t >( sampleRate / MINIMUM_FREQUENCY ) + 1;
+        m_exciteTable.reserve( maxPeriod );
+        m_randomBits.reserve( maxPeriod );
+    }
+    
     void setLPFCoef( T c )
     {
         m_lpf.setCoefficient( c );
@@ -154,8 +178,7 @@ public:
 //        m_lpf.reset();
         m_periodSamples = static_cast< int > ( periodSamples );
         m_exciteTable.resize( m_periodSamples );
-        std::vector< T > randomBits;
-        randomBits.resize( m_periodSamples );
+        m_randomBits.resize( m_periodSamples );
         // fill random table with 1 or minus 1
         static constexpr auto longsize = sizeof( long ) * CHAR_BIT;
         auto pos = 0;
@@ -166,7 +189,7 @@ public:
             for( auto i = 0; i < randNum.size(); i++ )
             {
                 auto val = randNum[ i ] ? noiseBlend : -noiseBlend;
-                randomBits[ pos ] = val;
+                m_randomBits[ pos ] = val;
                 pos += 1;
                 if ( pos == m_periodSamples )
                     break;
@@ -180,7 +203,7 @@ public:
             auto ampX1 = m_envelopeTable[ ampIndex ];
             auto ampX2 = m_envelopeTable[ ampIndex + 1];
             auto amp = sjf_interpolators::linearInterpolate( ampMu, ampX1, ampX2 ) * amplitude;
-            auto val = amp * ( (1 - noiseBlend) + randomBits[ i ] );
+            auto val = amp * ( (1 - noiseBlend) + m_randomBits[ i ] );
             m_exciteTable[ i ] = m_lpf.filterInput( val ) ;
         }
         m_readPointer = 0;
@@ -199,6 +222,11 @@ public:
     
     void setEnvelope( const T centrePoint, const T power )
     {
+        // only rebuild when the shape has changed, this is called at every note on
+        if ( centrePoint == m_envCentre && power == m_envPower )
+            return;
+        m_envCentre = centrePoint;
+        m_envPower = power;
         // first sample in envelope and last samples in envelope are always zero so it always returns to zero
         for ( auto i = 0; i < STEPS_IN_ENVELOPE; i++)
         {
@@ -219,7 +247,8 @@ private:
     const size_t STEPS_IN_ENVELOPE = 512;
     sjf_lpf< T > m_lpf;
     T m_periodSamples = 100;
-    std::vector< T > m_exciteTable, m_envelopeTable;
+    std::vector< T > m_exciteTable, m_envelopeTable, m_randomBits;
+    T m_envCentre = -1, m_envPower = -1;
     bool m_attackFlag = false;
     size_t m_readPointer = 0;
 };
@@ -324,8 +353,114 @@ private:
 //==============================================
 //==============================================
 //==============================================
+// tuning compensation for the medium dampers and the nonlinear allpass in sjf_waveguide
+// calculating the filter responses is too expensive to do at every note on,
+// so they are tabulated against midi pitch once per sample rate and interpolated when a note starts
+class sjf_waveguideTuningTable
+{
+public:
+    sjf_waveguideTuningTable( double sampleRate ) : m_SR( sampleRate )
+    {
+        m_damperDelay.resize( N_PITCHES * N_BRIGHTNESS );
+        m_nonLinDelay.resize( N_PITCHES * N_NONLIN );
+        for ( auto p = 0; p < N_PITCHES; p++ )
+        {
+            auto fundamental = midiToFrequency< double >( MIN_PITCH + p * PITCH_STEP );
+            for ( auto b = 0; b < N_BRIGHTNESS; b++ )
+            {
+                auto coef = damperCoefficient( fundamental, static_cast< double >( b ) / ( N_BRIGHTNESS - 1 ), m_SR );
+                auto apd = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { coef }, { 1.0, coef - 1.0 } );
+                m_damperDelay[ p * N_BRIGHTNESS + b ] = -2.0 * apd[ 2 ] * coef; // delay is roughly proportional to 1/coef so this interpolates much better
+            }
+            for ( auto n = 0; n < N_NONLIN; n++ )
+            {
+                auto a = nonLinFromIndex( n );
+                auto apdPos = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { a, 1.0 }, { 1.0, a } );
+                auto apdNeg = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { -a, 1.0 }, { 1.0, -a } );
+                m_nonLinDelay[ p * N_NONLIN + n ] = ( apdNeg[ 2 ] - apdPos[ 2 ] ) * 0.5;
+            }
+        }
+    }
+    ~sjf_waveguideTuningTable(){}
+
+    // returns a table for the sample rate, tables are shared by every waveguide running at the same rate
+    // NOT for the audio thread
+    static std::shared_ptr< const sjf_waveguideTuningTable > getTable( double sampleRate )
+    {
+        static std::mutex mutex;
+        static std::map< double, std::weak_ptr< const sjf_waveguideTuningTable > > tables;
+        std::lock_guard< std::mutex > lock( mutex );
+        if ( auto existing = tables[ sampleRate ].lock() )
+            return existing;
+        auto table = std::make_shared< const sjf_waveguideTuningTable >( sampleRate );
+        tables[ sampleRate ] = table;
+        return table;
+    }
+
+    // coefficient for the medium dampers, brightness 0 --> 1
+    static double damperCoefficient( double fundamental, double brightness, double sampleRate )
+    {
+        auto fCutOff = std::fmin( fundamental * std::pow( 2, ( brightness * 6.5 ) + 2 ), 20000 );
+        return calculateLPFCoefficient< double >( fCutOff, sampleRate );
+    }
+
+    // delay compensation ( in samples ) for the two medium dampers
+    // coefficient should be the result of damperCoefficient() for the same note and brightness
+    double getDamperCompensation( double midiPitch, double brightness, double coefficient ) const
+    {
+        return lookup( m_damperDelay, N_BRIGHTNESS, midiPitch, brightness * ( N_BRIGHTNESS - 1 ) ) / coefficient;
+    }
+
+    // delay compensation ( in samples ) for the asymmetric allpass with coefficients a and -a
+    double getNonLinearCompensation( double midiPitch, double a ) const
+    {
+        return lookup( m_nonLinDelay, N_NONLIN, midiPitch, ( a + NONLIN_MAX ) * ( N_NONLIN - 1 ) / ( 2.0 * NONLIN_MAX ) );
+    }
+
+    double getSampleRate() const
+    {
+        return m_SR;
+    }
+
+private:
+    static double nonLinFromIndex( int n )
+    {
+        return -NONLIN_MAX + ( 2.0 * NONLIN_MAX * n ) / ( N_NONLIN - 1 );
+    }
+
+    // bilinear interpolation between pitch rows and parameter columns
+    double lookup( const std::vector< double >& table, int nColumns, double midiPitch, double column ) const
+    {
+        auto row = ( midiPitch - MIN_PITCH ) / PITCH_STEP;
+        row = row < 0 ? 0 : ( row > N_PITCHES - 1 ? N_PITCHES - 1 : row );
+        column = column < 0 ? 0 : ( column > nColumns - 1 ? nColumns - 1 : column );
+        auto r0 = static_cast< int >( row );
+        auto c0 = static_cast< int >( column );
+        auto r1 = r0 < N_PITCHES - 1 ? r0 + 1 : r0;
+        auto c1 = c0 < nColumns - 1 ? c0 + 1 : c0;
+        auto rMu = row - r0;
+        auto cMu = column - c0;
+        auto y0 = sjf_interpolators::linearInterpolate( cMu, table[ r0 * nColumns + c0 ], table[ r0 * nColumns + c1 ] );
+        auto y1 = sjf_interpolators::linearInterpolate( cMu, table[ r1 * nColumns + c0 ], table[ r1 * nColumns + c1 ] );
+        return sjf_interpolators::linearInterpolate( rMu, y0, y1 );
+    }
 
+    static constexpr double MIN_PITCH = -4, PITCH_STEP = 0.5, NONLIN_MAX = 0.99;
+    static constexpr int N_PITCHES = 281; // -4 --> 136
+    static constexpr int N_BRIGHTNESS = 65, N_NONLIN = 129;
 
+    double m_SR = 44100;
+    std::vector< double > m_damperDelay, m_nonLinDelay;
+};
+
+//==============================================
+//==============================================
+//==============================================
+//==============================================
+
+// the waveguide can run in float or double
+// all of the tuning calculations are done in double whichever is used, only the audio path uses T
+template < class T = double >
 class sjf_waveguide
 {
 public:
@@ -339,10 +474,11 @@ public:
         m_emb.initialise( m_SR / MINIMUM_FREQUENCY );
         m_emb.setInterpolationType( sjf_interpolators::interpolatorTypes::allpass );
         
+        m_excitation.prepare( m_SR );
         m_excitation.setLPFCoef( calculateLPFCoefficient( 1000.0, m_SR ) );
         
         m_decayTable.prepare( m_SR );
-        
+        // the tuning table is only built in prepare(), building one here would just be thrown away
     }
     ~sjf_waveguide(){}
     
@@ -357,9 +493,11 @@ public:
         m_emb.initialise( m_SR / MINIMUM_FREQUENCY );
         m_emb.clearDelayline();
         
+        m_excitation.prepare( m_SR );
         m_excitation.setLPFCoef( calculateLPFCoefficient( 1000.0, m_SR ) );
         
         m_decayTable.prepare( m_SR );
+        m_tuning = sjf_waveguideTuningTable::getTable( m_SR );
     }
     
     void triggerNewNote( double midiPitch, double midiVelocity )
@@ -372,7 +510,7 @@ public:
         newNote( midiPitch, midiVelocity, split, stiff, sensor, pickPos, decay, medBright, exciteNoiseLevel, exciteEnvCentre, exciteEnvExponent, exciteEnvExtension, exciteNoiseBright, nonLinA, harmonicLevel, harmonicNumber );
     }
     
-    double processSample( int indexThroughCurrentBuffer )
+    T processSample( int indexThroughCurrentBuffer )
     {
         if ( !m_isPlayingFlag )
             return 0;
@@ -387,10 +525,10 @@ public:
         if ( m_harmBalance > 0 )
         {
             m_emb.setSample2( m_lastOutSamp * m_harmBalance );
-            outputSamp = sjf_cubic< double >( outputSamp + ( m_emb.getSample2() ) );
+            outputSamp = sjf_cubic< T >( outputSamp + ( m_emb.getSample2() ) );
         }
         // apply nonlinearity
-        m_lastOutSamp = applyNonlinearities( m_lastOutSamp*( 1.0 - m_harmBalance) + outputSamp );
+        m_lastOutSamp = applyNonlinearities( m_lastOutSamp*( 1 - m_harmBalance) + outputSamp );
         if( m_decayTable.getIsRunning() )
         {
             auto amp = m_decayTable.outputEnvelope();
@@ -422,7 +560,32 @@ public:
         m_lastOutSamp = m_oddHarmonicsFlag ? -m_lastOutSamp : m_lastOutSamp;
         return outputSamp;
     }
-    
+
+    // adds the output of the voice to a block of samples
+    // stops as soon as the voice has finished so idle voices cost nothing
+    template< typename Sample >
+    void addToBlock( Sample* output, int nSamples, Sample gain = 1 )
+    {
+        for ( auto i = 0; i < nSamples; i++ )
+        {
+            if ( !m_isPlayingFlag )
+                return;
+            output[ i ] += static_cast< Sample >( processSample( i ) ) * gain;
+        }
+    }
+
+    // fades the voice out over the decay table ( e.g. note off or when a voice is stolen )
+    void release()
+    {
+        if ( m_isPlayingFlag )
+            m_decayTable.startRunningEnvelope();
+    }
+
+    bool isReleasing()
+    {
+        return m_isPlayingFlag && m_decayTable.getIsRunning();
+    }
+
     // the split of total delay time between forward and backward travelling waves
     void setSplit( double split )
     {
@@ -554,7 +717,7 @@ public:
     }
     
     
-    std::vector< double >& getExciteEnvelope()
+    std::vector< T >& getExciteEnvelope()
     {
         return m_excitation.getEnvelope();
     }
@@ -624,33 +787,38 @@ public:
     }
     
 private:
+    // decayComp^exponent as exp( log( decayComp ) * exponent ) using the approximations from sjf_mathsApproximations.h instead of std::pow
+    // relative error is below 2e-7, the level at the end of the decay time moves by less than 0.0001dB over the whole range of notes
+    static double calculateFeedback( double decayComp, double exponent )
+    {
+        auto fb = sjf::maths::expApprox( sjf::maths::logApprox( decayComp ) * exponent );
+        return fb < 1.0 ? fb : 1.0; // the approximation must never let the loop gain go over 1
+    }
+
     void newNote( double midiPitch, double midiVelocity, double split, double stiff, double sensor, double pickPos, double decay, double medBright, double exciteNoiseLevel, double exciteEnvCentre, double exciteEnvExponent, double exciteEnvExtension, double exciteNoiseBright, double nonLinA, double harmonicLevel, double harmonicNumber )
     {
         
         DBG( split );
+        assert( m_tuning != nullptr ); // prepare() must be called before playing notes
+        if ( m_tuning == nullptr )
+            return;
         auto amplitude = midiVelocity / 127.0;
         auto fundamental = midiToFrequency< double >( midiPitch );
         
-        auto fCutOff = std::fmin(fundamental * std::pow( 2, ( medBright * 6.5 ) + 2 ), 20000 );
-        medBright = calculateLPFCoefficient< double > ( fCutOff, m_SR );
+        auto brightness = medBright;
+        medBright = sjf_waveguideTuningTable::damperCoefficient( fundamental, brightness, m_SR );
         for ( auto& lpf : m_mediumDampers )
             lpf.setCoefficient( medBright );
-        auto apd = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { medBright }, { 1.0, medBright - 1.0 } );
-        DBG( "del " << apd[2] );
-        auto delayCompensation = -2.0 * apd[ 2 ]; // tuning compensation for delays and feedback sections --> need to calculate properly
+        // tuning compensation for delays and feedback sections --> need to calculate properly
+        auto delayCompensation = m_tuning->getDamperCompensation( midiPitch, brightness, medBright );
         
         nonLinA *= (1.0 - medBright)*-1.0;
         if ( m_nonLinFlag1 )
-        {
-            apd = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { nonLinA, 1.0 }, { 1.0, nonLinA } );
-            delayCompensation -= apd[ 2 ] * 0.5;
-            apd = sjf_filterResponse< double >::calculateFilterResponse( fundamental, m_SR, { -nonLinA, 1.0 }, { 1.0, -nonLinA } );
-            delayCompensation -= -apd[ 2 ] * 0.5;
-        }
+            delayCompensation += m_tuning->getNonLinearCompensation( midiPitch, nonLinA );
         auto periodSeconds = 1.0 / fundamental;
         auto periodSamples = periodSeconds * m_SR;
         auto decayComp = ( 1.0 - abs( stiff ) ) * 0.001; // at 0 stiffness decay is time in seconds for drop by 60dB ( i.e. *0.001 )
-        m_fb = -1.0 * std::pow( decayComp, ( periodSeconds/(decay*2)) );
+        m_fb = -1.0 * calculateFeedback( decayComp, periodSeconds/(decay*2) );
         m_periodSamples = periodSamples + delayCompensation;
         auto p1 = (m_periodSamples * split);
         auto p2 = m_periodSamples - p1;
@@ -667,7 +835,7 @@ private:
                 m_onlyOneDirection = true;
                 p1 = p2 = m_periodSamples;
                 sensor1 = sensor2 = 0.5;
-                m_fb = std::pow( decayComp, ( periodSeconds/(decay)) );
+                m_fb = calculateFeedback( decayComp, periodSeconds/(decay) );
                 
 //                m_waveguide[ 0 ].setDelayInSamps( m_periodSamples );
 //                m_waveguide[ 0 ].setSensorPosition( 0.5 );
@@ -719,7 +887,7 @@ private:
             m_waveguide[ 1 ].setG( stiff );
 //        }
 
-        m_emb.setDelayTimeSamps( m_periodSamples / harmonicNumber );
+        m_emb.setDelayTimeSamps( sjf_waveguideSafeDelay< T >( m_periodSamples / harmonicNumber, m_SR / MINIMUM_FREQUENCY ) );
         m_harmBalance = harmonicLevel;
         
         m_excitation.setLPFCoef( exciteNoiseBright );
@@ -738,33 +906,35 @@ private:
 
     }
     
-    double applyNonlinearities( double x )
+    T applyNonlinearities( T x )
     {
         if ( m_nonLinFlag1 )
         {
-            return sjf_softClip< double >( ( m_apNonLin.process( x ) ) );
+            return sjf_softClip< T >( ( m_apNonLin.process( x ) ) );
         }
         return x;
     }
     
-    std::array< sjf_waveguideAllpass< double >, 2 > m_waveguide ;
-    sjf_delayLine< double > m_emb;
+    std::array< sjf_waveguideAllpass< T >, 2 > m_waveguide ;
+    sjf_delayLine< T > m_emb;
 
-    std::array< sjf_lpf< double >, 2 > m_mediumDampers;
-    sjf_pmExcitation< double > m_excitation;
-    sjf_asymAllpass< double > m_apNonLin;
+    std::array< sjf_lpf< T >, 2 > m_mediumDampers;
+    sjf_pmExcitation< T > m_excitation;
+    sjf_asymAllpass< T > m_apNonLin;
     
     double m_SR = 44100;
-    double m_split = 0.5, m_stiff = 0, m_sensorPos = 0.2, m_decaySeconds = 1, m_mediumBrightness = 0.7, m_pickPos = 0.1, m_exciteNoiseLevel = 1, m_exciteEnvCentre = 0.1, m_exciteEnvExponent = 1, m_exciteNoiseBrightness = 1, m_apnonLinA = 0, m_apNonLinANeg = 0, m_harmLevel = 0, m_harmNumber = 2, m_harmBalance = 0;
+    double m_split = 0.5, m_stiff = 0, m_sensorPos = 0.2, m_decaySeconds = 1, m_mediumBrightness = 0.7, m_pickPos = 0.1, m_exciteNoiseLevel = 1, m_exciteEnvCentre = 0.1, m_exciteEnvExponent = 1, m_exciteNoiseBrightness = 1, m_apnonLinA = 0, m_apNonLinANeg = 0, m_harmLevel = 0, m_harmNumber = 2;
+    T m_harmBalance = 0;
     bool m_oddHarmonicsFlag = false;
-    double m_fb = 0.99, m_periodSamples = 100, m_exciteExtension = 1, m_exciteCoef = 0.5;
-    double m_lastOutSamp = 0;
+    double m_periodSamples = 100, m_exciteExtension = 1, m_exciteCoef = 0.5;
+    T m_fb = 0.99, m_lastOutSamp = 0;
     
     int m_decayCount = 0, m_decayToSilenceSamps = (m_decaySeconds * m_SR * 2);
     bool m_isPlayingFlag = false, m_onlyOneDirection = false;
     bool m_nonLinFlag1 = false;
     
-    sjf_decayTable< double > m_decayTable;
+    sjf_decayTable< T > m_decayTable;
+    std::shared_ptr< const sjf_waveguideTuningTable > m_tuning;
 
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_waveguide )
@@ -0,0 +1,239 @@
+//
+//  sjf_waveguidePoly.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+//  Polyphonic engine built from a preallocated pool of sjf_waveguide voices
+//  Voices that have decayed to silence are put to sleep and skipped entirely,
+//  when the pool is full the oldest voice is stolen and faded out with its decay table
+//
+
+#ifndef sjf_waveguidePoly_h
+#define sjf_waveguidePoly_h
+
+#include "sjf_waveguide.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+template < class T = double >
+class sjf_waveguidePoly
+{
+public:
+    sjf_waveguidePoly( int nVoices = 8 )
+    {
+        setNumVoices( nVoices );
+    }
+    ~sjf_waveguidePoly(){}
+
+    // allocates the voice pool, NOT for the audio thread
+    // a few extra voices are kept in reserve so stolen voices can fade out while the new note starts
+    void setNumVoices( int nVoices )
+    {
+#ifndef NDEBUG
+        assert( nVoices > 0 );
+#endif
+        m_nVoices = nVoices;
+        auto total = static_cast< size_t >( nVoices + STEAL_HEADROOM );
+        while ( m_voices.size() > total )
+            m_voices.pop_back();
+        while ( m_voices.size() < total )
+            m_voices.push_back( std::make_unique< sjf_waveguide< T > >() );
+        // per voice bookkeeping kept in separate arrays so the allocation search only touches what it needs
+        m_notes.assign( total, -1 );
+        m_ages.assign( total, 0 );
+        m_isAwake.assign( total, false );
+        m_awake.clear();
+        m_awake.reserve( total );
+        for ( auto& v : m_voices )
+            v->prepare( m_SR );
+    }
+
+    int getNumVoices()
+    {
+        return m_nVoices;
+    }
+
+    void prepare( double sampleRate )
+    {
+        m_SR = sampleRate;
+        for ( auto& v : m_voices )
+            v->prepare( m_SR );
+        std::fill( m_isAwake.begin(), m_isAwake.end(), false );
+        std::fill( m_notes.begin(), m_notes.end(), -1 );
+        m_awake.clear();
+    }
+
+    void triggerNewNote( double midiPitch, double midiVelocity )
+    {
+        auto v = allocateVoice( midiPitch );
+        m_voices[ v ]->triggerNewNote( midiPitch, midiVelocity );
+    }
+
+    void triggerNewNote( double midiPitch, double midiVelocity, double split, double stiff, double sensor, double pickPos, double decay, double medBright, double exciteNoiseLevel, double exciteEnvCentre, double exciteEnvExponent, double exciteEnvExtension, double exciteNoiseBright, double nonLinA, double harmonicLevel, double harmonicNumber )
+    {
+        auto v = allocateVoice( midiPitch );
+        m_voices[ v ]->triggerNewNote( midiPitch, midiVelocity, split, stiff, sensor, pickPos, decay, medBright, exciteNoiseLevel, exciteEnvCentre, exciteEnvExponent, exciteEnvExtension, exciteNoiseBright, nonLinA, harmonicLevel, harmonicNumber );
+    }
+
+    // fades out any voice playing the given pitch
+    void releaseNote( double midiPitch )
+    {
+        auto note = static_cast< int >( midiPitch );
+        for ( auto v : m_awake )
+        {
+            if ( m_notes[ v ] != note )
+                continue;
+            m_voices[ v ]->release();
+            m_notes[ v ] = -1;
+        }
+    }
+
+    void releaseAll()
+    {
+        for ( auto v : m_awake )
+        {
+            m_voices[ v ]->release();
+            m_notes[ v ] = -1;
+        }
+    }
+
+    // adds the output of all active voices to the block
+    // each voice is run across the whole block in turn so its state stays in cache
+    void processBlock( T* output, int nSamples, T gain = 1 )
+    {
+        for ( auto v : m_awake )
+            m_voices[ v ]->addToBlock( output, nSamples, gain );
+        putFinishedVoicesToSleep();
+    }
+
+    void processBlock( juce::AudioBuffer< T >& buffer, T gain = 1 )
+    {
+        auto nSamps = buffer.getNumSamples();
+        auto nChannels = buffer.getNumChannels();
+        if ( nChannels < 1 )
+            return;
+        processBlock( buffer.getWritePointer( 0 ), nSamps, gain );
+        for ( auto c = 1; c < nChannels; c++ )
+            buffer.copyFrom( c, 0, buffer, 0, 0, nSamps );
+    }
+
+    T processSample( int indexThroughCurrentBuffer )
+    {
+        T output = 0;
+        for ( auto v : m_awake )
+            output += m_voices[ v ]->processSample( indexThroughCurrentBuffer );
+        return output;
+    }
+
+    // call at the end of each block when using processSample
+    void putFinishedVoicesToSleep()
+    {
+        auto n = 0;
+        for ( auto v : m_awake )
+        {
+            if ( m_voices[ v ]->isBusy() )
+                m_awake[ n++ ] = v;
+            else
+            {
+                m_isAwake[ v ] = false;
+                m_notes[ v ] = -1;
+            }
+        }
+        m_awake.resize( n );
+    }
+
+    // number of voices currently sounding ( including any that are fading out )
+    int getNumActiveVoices()
+    {
+        return static_cast< int >( m_awake.size() );
+    }
+
+    sjf_waveguide< T >& getVoice( int voiceNumber )
+    {
+        return *m_voices[ voiceNumber ];
+    }
+
+    //==============================================
+    // parameters are shared by all voices
+    void setSplit( double split ){ for ( auto& v : m_voices ) v->setSplit( split ); }
+    void setStiffness( double stiff ){ for ( auto& v : m_voices ) v->setStiffness( stiff ); }
+    void setSensorPosition( double sensorPos ){ for ( auto& v : m_voices ) v->setSensorPosition( sensorPos ); }
+    void setDecay( double decay ){ for ( auto& v : m_voices ) v->setDecay( decay ); }
+    void setMediumBrightness( double bright ){ for ( auto& v : m_voices ) v->setMediumBrightness( bright ); }
+    void setPickPosition( double pickPos ){ for ( auto& v : m_voices ) v->setPickPosition( pickPos ); }
+    void setExciteNoiseLevel( double noiseLevel ){ for ( auto& v : m_voices ) v->setExciteNoiseLevel( noiseLevel ); }
+    void setExciteEnvelopeParams( double centrePoint, double power ){ for ( auto& v : m_voices ) v->setExciteEnvelopeParams( centrePoint, power ); }
+    void setExcitationLengthFactor( double lengthFactor ){ for ( auto& v : m_voices ) v->setExcitationLengthFactor( lengthFactor ); }
+    void setNonLinearity( bool nonLin1ShouldBeOn ){ for ( auto& v : m_voices ) v->setNonLinearity( nonLin1ShouldBeOn ); }
+    void setNonLin1Factor( double a ){ for ( auto& v : m_voices ) v->setNonLin1Factor( a ); }
+    void setHarmonic( double a, int harmNumber ){ for ( auto& v : m_voices ) v->setHarmonic( a, harmNumber ); }
+    void setExcitationCutoff( double f ){ for ( auto& v : m_voices ) v->setExcitationCutoff( f ); }
+    void setOddHarmonicsOnly( bool shouldBeOn ){ for ( auto& v : m_voices ) v->setOddHarmonicsOnly( shouldBeOn ); }
+
+private:
+    // finds a voice for a new note
+    //      --> a sleeping voice if there is one
+    //      --> if all m_nVoices are already ringing the oldest is released so it fades out on its decay table
+    //          while the new note takes one of the reserve voices
+    //      --> if even the reserve is in use the oldest voice is retriggered directly
+    size_t allocateVoice( double midiPitch )
+    {
+        auto nRinging = 0;
+        auto oldestRinging = NO_VOICE;
+        for ( auto v : m_awake )
+        {
+            if ( m_voices[ v ]->isReleasing() )
+                continue;
+            nRinging++;
+            if ( oldestRinging == NO_VOICE || m_ages[ v ] < m_ages[ oldestRinging ] )
+                oldestRinging = v;
+        }
+        if ( nRinging >= m_nVoices && oldestRinging != NO_VOICE )
+        {
+            m_voices[ oldestRinging ]->release();
+            m_notes[ oldestRinging ] = -1;
+        }
+
+        auto voice = NO_VOICE;
+        for ( size_t v = 0; v < m_voices.size(); v++ )
+        {
+            if ( !m_isAwake[ v ] )
+            {
+                voice = v;
+                break;
+            }
+        }
+        if ( voice == NO_VOICE )
+        {
+            for ( auto v : m_awake )
+                if ( voice == NO_VOICE || m_ages[ v ] < m_ages[ voice ] )
+                    voice = v;
+        }
+        else
+        {
+            m_isAwake[ voice ] = true;
+            m_awake.push_back( voice );
+        }
+        m_notes[ voice ] = static_cast< int >( midiPitch );
+        m_ages[ voice ] = ++m_noteCount;
+        return voice;
+    }
+
+    static constexpr int STEAL_HEADROOM = 2;
+    static constexpr size_t NO_VOICE = std::numeric_limits< size_t >::max();
+
+    std::vector< std::unique_ptr< sjf_waveguide< T > > > m_voices;
+    std::vector< int > m_notes;
+    std::vector< uint64_t > m_ages;
+    std::vector< bool > m_isAwake;
+    std::vector< size_t > m_awake; // indices of voices that need processing
+
+    double m_SR = 44100;
+    int m_nVoices = 8;
+    uint64_t m_noteCount = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_waveguidePoly )
+};
+
+#endif /* sjf_waveguidePoly_h */
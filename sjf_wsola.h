@@ -0,0 +1,294 @@
+//
+//  sjf_wsola.h
+//
+//  Created by Simon Fay on 19/10/2026.
+//
+
+#ifndef sjf_wsola_h
+#define sjf_wsola_h
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cassert>
+#include <complex>
+#include "sjf_fft.h"
+
+namespace sjf::timestretch
+{
+    /**
+     Real time WSOLA ( waveform similarity overlap add ) time stretching, the streaming counterpart to sjf_sola::stretch
+     Frames of frameSize samples are windowed ( hann ) and overlap added every frameSize / 2 output samples,
+     the input is read every frameSize / ( 2 * stretchFactor ) samples so the tempo changes without changing the pitch
+     Each frame is moved by up to +/- tolerance samples to the position that best lines up with the natural continuation of the previous frame,
+     the similarity of every candidate position is found at once with an fft cross correlation ( as sjf_sola does for large overlaps )
+
+     The stretcher pulls its input rather than having a fixed input to output ratio, so it fits a sampler reading from a buffer:
+        --> prepare() with the number of channels and the largest block size, this allocates so NOT on the audio thread
+        --> each block ask getInputRequired( nSamples ) for how many new input samples the next nSamples of output need
+        --> process( input, output, nSamples ) with input holding that many samples
+     The look ahead is bounded to getLookAhead() samples beyond the current position, nothing allocates after prepare()
+     */
+    template < typename Sample >
+    class wsola
+    {
+    public:
+        wsola(){}
+        ~wsola(){}
+
+        /**
+         frameSize must be even, tolerance should be less than frameSize / 2
+         Allocates, NOT for the audio thread
+         */
+        void prepare( int nChannels, int maxBlockSize, int frameSize = 1024, int tolerance = 128 )
+        {
+            assert( frameSize >= 4 && frameSize % 2 == 0 );
+            assert( tolerance >= 0 && tolerance < frameSize / 2 );
+            m_nChannels = nChannels;
+            m_maxBlockSize = maxBlockSize;
+            m_frameSize = frameSize;
+            m_synthesisHop = frameSize / 2;
+            m_tolerance = tolerance;
+
+            // periodic hann, at 50% overlap the windows add up to exactly 1
+            m_window.resize( frameSize );
+            for ( auto i = 0; i < frameSize; ++i )
+                m_window[ i ] = static_cast< Sample >( 0.5 - 0.5 * std::cos( 2.0 * M_PI * i / frameSize ) );
+
+            // the most input a single call can add is a hop per synthesis hop ( plus the extra first hop ) at the fastest speed,
+            // on top of the look ahead already buffered
+            const auto maxHops = ( maxBlockSize + m_synthesisHop - 1 ) / m_synthesisHop + 1;
+            const auto maxAnalysisHop = static_cast< int >( std::ceil( m_synthesisHop / MIN_STRETCH ) );
+            m_inputCapacity = getLookAhead() + m_synthesisHop + ( maxHops + 1 ) * maxAnalysisHop;
+
+            m_input.resize( nChannels );
+            m_overlap.resize( nChannels );
+            m_output.resize( nChannels );
+            for ( auto c = 0; c < nChannels; ++c )
+            {
+                m_input[ c ].assign( m_inputCapacity, 0 );
+                m_overlap[ c ].assign( frameSize, 0 );
+                m_output[ c ].assign( maxBlockSize + m_synthesisHop, 0 );
+            }
+            // every candidate start reads overlapLength samples from a region 2 * tolerance + overlapLength long,
+            // an fft that size holds the correlation without it wrapping round
+            const auto overlapLength = frameSize - m_synthesisHop;
+            m_fft.prepare( sjf::spectral::nextPowerOf2( 2 * tolerance + overlapLength ) );
+            m_spectrum.assign( m_fft.getSize(), 0 );
+            m_crossSpectrum.assign( m_fft.getSize(), 0 );
+            m_energy.assign( 2 * tolerance + 1, 0 );
+            setStretchFactor( m_stretch );
+            reset();
+        }
+
+        /** Clear all buffered input and output ( e.g. when a new note starts ), the next output starts at the next input */
+        void reset()
+        {
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                std::fill( m_input[ c ].begin(), m_input[ c ].end(), 0 );
+                std::fill( m_overlap[ c ].begin(), m_overlap[ c ].end(), 0 );
+            }
+            // half a frame of silence before the input so the first frame that is heard has its full weight at the first input sample
+            m_inputEnd = m_synthesisHop;
+            m_analysisPos = 0;
+            m_prevStart = 0;
+            m_outputCount = 0;
+            m_isFirstHop = true;
+        }
+
+        /**
+         Output length / input length, e.g. 2 --> half speed, 0.5 --> double speed
+         Limited to 0.25 --> 4
+         Do not change it between getInputRequired() and process()
+         */
+        void setStretchFactor( Sample stretchFactor )
+        {
+            m_stretch = std::clamp( stretchFactor, static_cast< Sample >( MIN_STRETCH ), static_cast< Sample >( MAX_STRETCH ) );
+            m_analysisHop = static_cast< double >( m_synthesisHop ) / m_stretch;
+        }
+
+        Sample getStretchFactor() const { return m_stretch; }
+
+        /** The number of new input samples that process() needs to produce the next nSamples of output */
+        int getInputRequired( int nSamples ) const
+        {
+            auto hops = nSamples > m_outputCount ? ( nSamples - m_outputCount + m_synthesisHop - 1 ) / m_synthesisHop : 0;
+            if ( hops == 0 )
+                return 0;
+            if ( m_isFirstHop )
+                ++hops;
+            // positions are stepped exactly as processHop() steps them, so the rounding is the same
+            auto pos = m_analysisPos;
+            for ( auto h = 1; h < hops; ++h )
+                pos += m_analysisHop;
+            const auto highest = static_cast< int >( std::lround( pos ) ) + m_tolerance + m_frameSize;
+            return std::max( highest - m_inputEnd, 0 );
+        }
+
+        /**
+         Produce nSamples of stretched output ( no more than the maxBlockSize given to prepare() )
+            input must hold getInputRequired( nSamples ) samples for each channel
+         */
+        void process( const Sample* const* input, Sample* const* output, int nSamples )
+        {
+            assert( nSamples <= m_maxBlockSize );
+            const auto nIn = getInputRequired( nSamples );
+            discardUsedInput();
+            assert( m_inputEnd + nIn <= m_inputCapacity );
+            for ( auto c = 0; c < m_nChannels; ++c )
+                std::copy( input[ c ], input[ c ] + nIn, m_input[ c ].begin() + m_inputEnd );
+            m_inputEnd += nIn;
+
+            while ( m_outputCount < nSamples )
+                processHop();
+
+            const auto remaining = m_outputCount - nSamples;
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                auto* out = m_output[ c ].data();
+                std::copy( out, out + nSamples, output[ c ] );
+                std::copy( out + nSamples, out + m_outputCount, out );
+            }
+            m_outputCount = remaining;
+        }
+
+        /** The furthest beyond the current read position that input is needed */
+        int getLookAhead() const { return m_frameSize + m_tolerance; }
+
+        int getFrameSize() const { return m_frameSize; }
+        int getTolerance() const { return m_tolerance; }
+
+    private:
+        static constexpr double MIN_STRETCH = 0.25, MAX_STRETCH = 4;
+
+        // pick the best frame near the current analysis position, overlap add it and move a synthesis hop of output to the output buffer
+        void processHop()
+        {
+            const auto target = static_cast< int >( std::lround( m_analysisPos ) );
+            auto start = target;
+            if ( !m_isFirstHop )
+                start = findBestStart( std::max( target - m_tolerance, 0 ), target + m_tolerance );
+            assert( start + m_frameSize <= m_inputEnd );
+
+            const auto* window = m_window.data();
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                auto* ola = m_overlap[ c ].data();
+                const auto* in = m_input[ c ].data() + start;
+                for ( auto i = 0; i < m_frameSize; ++i )
+                    ola[ i ] += in[ i ] * window[ i ];
+            }
+
+            // the first synthesis hop only holds the silence before the input
+            if ( !m_isFirstHop )
+            {
+                for ( auto c = 0; c < m_nChannels; ++c )
+                    std::copy( m_overlap[ c ].begin(), m_overlap[ c ].begin() + m_synthesisHop, m_output[ c ].begin() + m_outputCount );
+                m_outputCount += m_synthesisHop;
+            }
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                auto& ola = m_overlap[ c ];
+                std::copy( ola.begin() + m_synthesisHop, ola.end(), ola.begin() );
+                std::fill( ola.end() - m_synthesisHop, ola.end(), 0 );
+            }
+
+            m_prevStart = start;
+            m_analysisPos += m_analysisHop;
+            m_isFirstHop = false;
+        }
+
+        /**
+         The start between first and last whose first half is most like the second half of the previous frame
+         correlation / sqrt( energy ) ( summed across channels ) so a candidate is not chosen just for being loud
+         The correlation with every candidate comes from one fft per channel and one inverse,
+         the previous frame's overlap goes in the real part and the search region in the imaginary part ( see sjf_sola )
+         */
+        int findBestStart( int first, int last )
+        {
+            using complex = std::complex< double >;
+            const auto natural = m_prevStart + m_synthesisHop;
+            const auto overlapLength = m_frameSize - m_synthesisHop;
+            const auto nCandidates = last - first + 1;
+            const auto regionLength = nCandidates - 1 + overlapLength;
+            const auto P = m_fft.getSize();
+            std::fill( m_crossSpectrum.begin(), m_crossSpectrum.end(), complex( 0, 0 ) );
+            std::fill( m_energy.begin(), m_energy.begin() + nCandidates, 0 );
+            for ( auto c = 0; c < m_nChannels; ++c )
+            {
+                const auto* a = m_input[ c ].data() + natural;
+                const auto* b = m_input[ c ].data() + first;
+                for ( auto i = 0; i < regionLength; ++i )
+                    m_spectrum[ i ] = complex( i < overlapLength ? a[ i ] : 0, b[ i ] );
+                std::fill( m_spectrum.begin() + regionLength, m_spectrum.end(), complex( 0, 0 ) );
+                m_fft.perform( m_spectrum, false );
+                for ( size_t k = 0; k < P; ++k )
+                {
+                    // conj( A ) * B from Z = A + iB, as in sjf_sola::calculateCrossCorrelationTimeLagFFT
+                    const auto& z = m_spectrum[ k ];
+                    const auto& zm = m_spectrum[ ( P - k ) & ( P - 1 ) ];
+                    auto re = z.real() * z.real() + z.imag() * z.imag() - zm.real() * zm.real() - zm.imag() * zm.imag();
+                    auto im = 2.0 * ( zm.real() * z.imag() + zm.imag() * z.real() );
+                    m_crossSpectrum[ k ] += complex( im * 0.25, -re * 0.25 );
+                }
+                // energy of each candidate as a running sum
+                double energy = 0;
+                for ( auto i = 0; i < overlapLength; ++i )
+                    energy += static_cast< double >( b[ i ] ) * b[ i ];
+                m_energy[ 0 ] += energy;
+                for ( auto s = 1; s < nCandidates; ++s )
+                {
+                    energy += static_cast< double >( b[ s + overlapLength - 1 ] ) * b[ s + overlapLength - 1 ] - static_cast< double >( b[ s - 1 ] ) * b[ s - 1 ];
+                    m_energy[ s ] += energy;
+                }
+            }
+            m_fft.perform( m_crossSpectrum, true );
+
+            auto bestStart = natural >= first && natural <= last ? natural : first;
+            auto bestScore = -1e30;
+            // anything quieter than this is treated as silence, where the running sum is only rounding error
+            const auto minEnergy = 1e-12 * overlapLength * m_nChannels;
+            for ( auto s = 0; s < nCandidates; ++s )
+            {
+                if ( m_energy[ s ] <= minEnergy )
+                    continue;
+                // the inverse fft is not scaled, but the same scale on every candidate does not change which is best
+                const auto score = m_crossSpectrum[ s ].real() / std::sqrt( m_energy[ s ] );
+                if ( score > bestScore )
+                {
+                    bestScore = score;
+                    bestStart = first + s;
+                }
+            }
+            return bestStart;
+        }
+
+        // move the input that is still needed to the start of the buffer
+        void discardUsedInput()
+        {
+            const auto lowest = std::min( m_prevStart + m_synthesisHop, static_cast< int >( std::lround( m_analysisPos ) ) - m_tolerance );
+            const auto shift = std::min( lowest, m_inputEnd );
+            if ( shift <= 0 )
+                return;
+            for ( auto& in : m_input )
+                std::copy( in.begin() + shift, in.begin() + m_inputEnd, in.begin() );
+            m_inputEnd -= shift;
+            m_prevStart -= shift;
+            m_analysisPos -= shift;
+        }
+
+        std::vector< std::vector< Sample > > m_input, m_overlap, m_output;
+        std::vector< Sample > m_window;
+        sjf::spectral::fft< double > m_fft;
+        std::vector< std::complex< double > > m_spectrum, m_crossSpectrum;
+        std::vector< double > m_energy;
+        Sample m_stretch = 1;
+        double m_analysisPos = 0, m_analysisHop = 512;
+        int m_nChannels = 0, m_maxBlockSize = 0, m_frameSize = 1024, m_synthesisHop = 512, m_tolerance = 128, m_inputCapacity = 0;
+        int m_inputEnd = 0, m_prevStart = 0, m_outputCount = 0;
+        bool m_isFirstHop = true;
+    };
+}
+
+#endif /* sjf_wsola_h */
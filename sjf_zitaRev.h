@@ -22,6 +22,7 @@
 #include <time.h>
 #include "gcem/include/gcem.hpp"
 #include "sjf_compileTimeRandom.h"
+#include "sjf_filters/sjf_smootherBank.h"
 //==============================================================================
 //==============================================================================
 //==============================================================================
@@ -175,8 +176,8 @@ private:
     static constexpr T DRIVE = 1.01f;
     
     int m_nInChannels = 2, m_nOutChannels = 2;
-    T m_dry = 0, m_wet = 1, m_FB = 0.85, m_size = 1, m_modD = 0.1;
-    T m_shimLevel = 0, m_shimTranspose = 2;
+    T m_dry = 0, m_wet = 1, m_size = 1;
+    T m_shimLevel = 0;
     T m_lrLPFCutoff = 0.99, m_lrHPFCutoff = 0.001;
     T m_inputLPFCutoff = 0.7, m_inputHPFCutoff = 0.01;
     T m_diffusion = 0.6;
@@ -200,17 +201,20 @@ private:
     sjf_pitchShift< T > m_shimmer; // shimmer
     sjf_lpf< T > m_shimLPF, m_shimLPF2, m_shimHPF;
     
-    sjf_lpf< T > m_modDSmooth, m_shimTransposeSmooth, m_FBsmooth, m_diffusionSmooth; // dezipper variables
-    std::array< sjf_lpf< T >, NUM_REV_CHANNELS > m_hiPass, m_lowPass, m_erSizeSmooth, m_lrSizeSmooth; // dezipper individual delay times
+    // dezipped parameters and individual delay times are smoothed together, a chunk of samples at a time
+    enum smoothedParams { modDepth, shimTranspose, feedback, diffusion, NGLOBALPARAMS };
+    static constexpr int ER_SIZE_PARAM = NGLOBALPARAMS; // one per channel
+    static constexpr int LR_SIZE_PARAM = ER_SIZE_PARAM + NUM_REV_CHANNELS; // one per channel
+    static constexpr int GL_ER_SIZE_PARAM = LR_SIZE_PARAM + NUM_REV_CHANNELS; // one per stage and channel
+    static constexpr int NSMOOTHEDPARAMS = GL_ER_SIZE_PARAM + NUM_ER_STAGES * NUM_REV_CHANNELS;
+    static constexpr int SMOOTHING_BLOCK_SIZE = 64;
+    sjf::filters::smootherBank< T, NSMOOTHEDPARAMS, sjf::filters::smootherType::onepole > m_smoothers;
+    std::array< sjf_lpf< T >, NUM_REV_CHANNELS > m_hiPass, m_lowPass;
     
     std::array< sjf_lpf< T >, NUM_REV_CHANNELS > m_inputLPF, m_inputHPF/*, m_DCBlockers*/;
     sjf_lpf < T > m_midsideHPF;
     
-    std::array< T, NUM_REV_CHANNELS > m_erDelayTimesSamples, m_lrDelayTimesSamples;
-
-    std::array< std::array< sjf_lpf< T >, NUM_REV_CHANNELS >, NUM_ER_STAGES > m_glERSizeSmooth;
     std::array< std::array< bool, NUM_REV_CHANNELS >, NUM_ER_STAGES > m_glERFlip;
-    std::array< std::array< T, NUM_REV_CHANNELS >, NUM_ER_STAGES > m_glERDelayTimesSamps;
 
     std::array< sjf_delayLine< T >, NUM_REV_CHANNELS > m_multitapErDelays;
     std::array< std::array< T, NUM_TAPS >, NUM_REV_CHANNELS > m_multitapERDelayTimesSamps, m_multitapERScaling;
@@ -221,6 +225,12 @@ public:
     sjf_zitaRev()
     {
         m_revSamples.fill( 0 );
+        m_smoothers.prepare( SMOOTHING_BLOCK_SIZE );
+        m_smoothers.setCoefficient( 0.5f );
+        m_smoothers.setTarget( smoothedParams::modDepth, 0.1f );
+        m_smoothers.setTarget( smoothedParams::shimTranspose, 2.0f );
+        m_smoothers.setTarget( smoothedParams::feedback, 0.85f );
+        m_smoothers.setTarget( smoothedParams::diffusion, m_diffusion );
         setinputHPFCutoff( m_inputHPFCutoff );
         setinputLPFCutoff( m_inputLPFCutoff );
         setLrHPFCutoff( m_lrHPFCutoff );
@@ -259,7 +269,7 @@ public:
     {
         const auto bufferSize = buffer.getNumSamples();
         static constexpr T hadScale = 1.0f / gcem::sqrt( NUM_REV_CHANNELS );
-        static constexpr auto sinTab = sinArray< T, TABSIZE >();
+        static constexpr const sinArray< T, TABSIZE >& sinTab = sjf_sinTable< T, TABSIZE >;
         
         T modDepthSmoothed, FBSmoothed, diffusionSmoothed, phasorOut/*, drySamp, wetSamp, dt,  shimOutput,  mid, side*/;
         
@@ -271,15 +281,20 @@ public:
         const T shimDryLevel = sqrt( 1 - m_shimLevel );
         
         const T inScale = 1.0f / sqrt( (T)m_nInChannels );
+        const T *modDepthRamp = m_smoothers.getRamp( smoothedParams::modDepth ), *shimTransposeRamp = m_smoothers.getRamp( smoothedParams::shimTranspose );
+        const T *FBRamp = m_smoothers.getRamp( smoothedParams::feedback ), *diffusionRamp = m_smoothers.getRamp( smoothedParams::diffusion );
         
         for ( int indexThroughBuffer = 0; indexThroughBuffer < bufferSize; indexThroughBuffer++ )
         {
-            // first calculate smoothed global variables
-            modDepthSmoothed = m_modType ? m_modDSmooth.filterInput( m_modD ) : m_modDSmooth.filterInput( m_modD ) * 0.5f; // sine modulation seems more extreme than random so if using sine temper it somewhat
+            // first calculate smoothed global variables, these are calculated for a chunk of samples at a time
+            auto indexThroughChunk = indexThroughBuffer % SMOOTHING_BLOCK_SIZE;
+            if ( indexThroughChunk == 0 )
+                m_smoothers.process( std::min( SMOOTHING_BLOCK_SIZE, bufferSize - indexThroughBuffer ) );
+            modDepthSmoothed = m_modType ? modDepthRamp[ indexThroughChunk ] : modDepthRamp[ indexThroughChunk ] * 0.5f; // sine modulation seems more extreme than random so if using sine temper it somewhat
             modulateDelays = ( modDepthSmoothed <= 0 ) ? false : true;
             
-            FBSmoothed = m_FBsmooth.filterInput( m_FB );
-            diffusionSmoothed = m_diffusionSmooth.filterInput( m_diffusion );
+            FBSmoothed = FBRamp[ indexThroughChunk ];
+            diffusionSmoothed = diffusionRamp[ indexThroughChunk ];
             
             phasorOut = m_modPhasor.output() * TABSIZE;
             
@@ -290,8 +305,8 @@ public:
             
             setAllpassCoefficients( diffusionSmoothed );
             // calculate allpass delay times
-            setAllPassDelayTimes( sinTab, modDepthSmoothed, modulateDelays, phasorOut /*, dt */);
-            setERGLDelayTimes(); // no smoothing to save cpu????
+            setAllPassDelayTimes( sinTab, modDepthSmoothed, modulateDelays, phasorOut, indexThroughChunk /*, dt */);
+            setERGLDelayTimes( indexThroughChunk ); // no smoothing to save cpu????
             setMultitapScaling( diffusionSmoothed );
             // different early reflection types
             switch( m_erType )
@@ -329,7 +344,7 @@ public:
                 m_delays[ i ].setSample2( m_revSamples[ i ] ); // feed through delay lines
             }
 
-            setLateReflectionDelayTimes( sinTab, modDepthSmoothed, modulateDelays, phasorOut /*, dt */);
+            setLateReflectionDelayTimes( sinTab, modDepthSmoothed, modulateDelays, phasorOut, indexThroughChunk /*, dt */);
 
             for ( int i = 0; i < NUM_REV_CHANNELS; i++ )
             {
@@ -342,7 +357,7 @@ public:
             }
 //            Householder< T, NUM_REV_CHANNELS >::mixInPlace( m_revSamples );
             // SHIMMER
-            if ( shimmerOn ) { processShimmer( shimDryLevel, shimWetLevel ); }
+            if ( shimmerOn ) { processShimmer( shimDryLevel, shimWetLevel, shimTransposeRamp[ indexThroughChunk ] ); }
         }
     }
     //==============================================================================
@@ -368,7 +383,7 @@ public:
     //==============================================================================
     void setModulationDepth( const T &newModDepth )
     {
-        m_modD = sjf_scale< T > ( newModDepth, 0, 100, -0.00001, 0.999f );
+        m_smoothers.setTarget( smoothedParams::modDepth, sjf_scale< T > ( newModDepth, 0, 100, -0.00001, 0.999f ) );
     }
     //==============================================================================
     void setModulationType( const bool& trueForRandomFalseForSin )
@@ -378,7 +393,7 @@ public:
     //==============================================================================
     void setDecay( const T &newDecay )
     {
-        m_FB = sjf_scale< T > ( newDecay, 0, 100, 0, 1. );// * 0.01;
+        m_smoothers.setTarget( smoothedParams::feedback, sjf_scale< T > ( newDecay, 0, 100, 0, 1. ) );// * 0.01;
     }
     //==============================================================================
     void setMix( const T &newMix )
@@ -434,7 +449,7 @@ public:
     //==============================================================================
     void setShimmerTransposition( const T &newShimmerTransposition )
     {
-        m_shimTranspose = pow( 2.0f, ( newShimmerTransposition / 12.0f ) );
+        m_smoothers.setTarget( smoothedParams::shimTranspose, pow( 2.0f, ( newShimmerTransposition / 12.0f ) ) );
     }
     //==============================================================================
     void setInterpolationType( const int &newInterpolation )
@@ -471,6 +486,7 @@ public:
     void setDiffusion( const T& diffusion )
     {
         m_diffusion = sjf_scale< T >( diffusion, 0, 100, 0.001, 0.6 );
+        m_smoothers.setTarget( smoothedParams::diffusion, m_diffusion );
     }
     //==============================================================================
     void setMonoLow( const bool& trueIfMonoLow )
@@ -539,13 +555,13 @@ private:
         }
     }
     //==============================================================================
-    inline void setAllPassDelayTimes( const sinArray< T, TABSIZE >& sinTab, const T& modDepthSmoothed, const bool& modulateDelays, T& phasorOut/*, T& dt*/ )
+    inline void setAllPassDelayTimes( const sinArray< T, TABSIZE >& sinTab, const T& modDepthSmoothed, const bool& modulateDelays, T& phasorOut, const int& indexThroughChunk/*, T& dt*/ )
     {
         T dt;
         for ( int i = 0; i < NUM_REV_CHANNELS; i++ )
         {
             // calculate allpass delay times
-            dt = m_erSizeSmooth[ i ].filterInput( m_erDelayTimesSamples[ i ] );
+            dt = m_smoothers.getRamp( ER_SIZE_PARAM + i )[ indexThroughChunk ];
             if ( modulateDelays )
             {
                 if ( m_modType )
@@ -561,13 +577,13 @@ private:
         }
     }
     //==============================================================================
-    inline void setERGLDelayTimes()
+    inline void setERGLDelayTimes( const int& indexThroughChunk )
     {
         for ( int s = 0; s < NUM_ER_STAGES; s++ )
         {
             for ( int c = 0; c < NUM_REV_CHANNELS; c++ )
             {
-                m_erGLDelays[ s ][ c ].setDelayTimeSamps( m_glERSizeSmooth[ s ][ c ].filterInput(m_glERDelayTimesSamps[ s ][ c ] ) );
+                m_erGLDelays[ s ][ c ].setDelayTimeSamps( m_smoothers.getRamp( GL_ER_SIZE_PARAM + s * NUM_REV_CHANNELS + c )[ indexThroughChunk ] );
             }
         }
     }
@@ -687,7 +703,7 @@ private:
         }
     }
     //==============================================================================
-    inline void setLateReflectionDelayTimes( const sinArray< T, TABSIZE >& sinTab, const T& modDepthSmoothed, const bool& modulateDelays, T& phasorOut )
+    inline void setLateReflectionDelayTimes( const sinArray< T, TABSIZE >& sinTab, const T& modDepthSmoothed, const bool& modulateDelays, T& phasorOut, const int& indexThroughChunk )
     {
         T dt;
         phasorOut += PHASOR_OFFSET2; // shift latereflection offset so they're misaligned with allpass
@@ -695,7 +711,7 @@ private:
         // save delayed values for next sample
         for ( int i = 0; i < NUM_REV_CHANNELS; i++ )
         {
-            dt = m_lrSizeSmooth[ i ].filterInput( m_lrDelayTimesSamples[ i ] );
+            dt = m_smoothers.getRamp( LR_SIZE_PARAM + i )[ indexThroughChunk ];
             if ( modulateDelays )
             {
                 if ( m_modType )
@@ -711,13 +727,13 @@ private:
         }
     }
     //==============================================================================
-    inline void processShimmer( const T& shimDryLevel, const T& shimWetLevel )
+    inline void processShimmer( const T& shimDryLevel, const T& shimWetLevel, const T& shimTransposeSmoothed )
     {
         constexpr int lastChannel = NUM_REV_CHANNELS - 1;
         T shimOutput;
         
         m_shimmer.setSample( m_shimLPF.filterInput( m_revSamples[ lastChannel ] ) ); // no need to pitchShift Everything because it all gets mixed anyway
-        shimOutput = m_shimmer.pitchShiftOutput( m_shimTransposeSmooth.filterInput( m_shimTranspose ) ) ;
+        shimOutput = m_shimmer.pitchShiftOutput( shimTransposeSmoothed ) ;
         m_shimHPF.filterInPlaceHP( shimOutput );
         m_shimLPF2.filterInPlace( shimOutput );
         m_revSamples[ lastChannel ] *= shimDryLevel;
@@ -741,11 +757,11 @@ private:
         T sizeFactor = proportionOfMaxSize * 0.5; // max delay vector size is double max delay time!!!
         for ( int i = 0; i < NUM_REV_CHANNELS; i++ )
         {
-            m_erDelayTimesSamples[ i ] = m_allpass[ i ].size() * sizeFactor;
-            m_lrDelayTimesSamples[ i ] = m_delays[ i ].size() * sizeFactor;
+            m_smoothers.setTarget( ER_SIZE_PARAM + i, m_allpass[ i ].size() * sizeFactor );
+            m_smoothers.setTarget( LR_SIZE_PARAM + i, m_delays[ i ].size() * sizeFactor );
             for ( int s = 0; s < NUM_ER_STAGES; s++ )
             {
-                m_glERDelayTimesSamps[ s ][ i ] = m_erGLDelays[ s ][ i ].size() * sizeFactor;
+                m_smoothers.setTarget( GL_ER_SIZE_PARAM + s * NUM_REV_CHANNELS + i, m_erGLDelays[ s ][ i ].size() * sizeFactor );
             }
             const T sampsPerMS = m_SR * 0.001;
 //            static constexpr std::array< glVelvetDelayTimes< 1, NUM_TAPS, MAX_ER_TIME >, NUM_REV_CHANNELS > multiTapTimes;
@@ -821,23 +837,7 @@ private:
     //==============================================================================
     void initialiseVariableSmoothers( const T& smoothSlewVal )
     {
-        m_shimTransposeSmooth.setCutoff( smoothSlewVal );
-        
-        m_modDSmooth.setCutoff( smoothSlewVal );
-        m_FBsmooth.setCutoff( smoothSlewVal );
-        m_diffusionSmooth.setCutoff( smoothSlewVal );
-        
-        for ( int i = 0; i < NUM_REV_CHANNELS; i++ )
-        {
-            m_erSizeSmooth[ i ].setCutoff( smoothSlewVal );
-            m_lrSizeSmooth[ i ].setCutoff( smoothSlewVal );
-            
-            for ( int s = 0; s < NUM_ER_STAGES; s++ )
-            {
-                m_glERSizeSmooth[ s ][ i ].setCutoff( smoothSlewVal );
-            }
-        }
-        
+        m_smoothers.setCoefficient( smoothSlewVal );
     }
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR ( sjf_zitaRev )